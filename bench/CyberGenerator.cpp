@@ -0,0 +1,272 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 18 October 2026, 10:15 AM
+ *  File    : CyberGenerator.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "CyberGenerator.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string_view>
+
+#include "../include/CyberFile.hpp"
+
+namespace nt {
+
+namespace {
+
+constexpr size_t WRITE_SIZE = 1 << 20;
+constexpr uint64_t HUGE_SIZE = 256ULL << 20;
+constexpr uint64_t SPARSE_SIZE = 1ULL << 30;
+constexpr uint64_t SPARSE_STEP = 16ULL << 20;
+constexpr size_t SPARSE_ISLAND = 64 << 10;
+constexpr size_t DEEP_LEVELS = 128;
+
+constexpr std::array<std::string_view, 16> WORDS = {
+    "backup ", "restore ", "chunk ", "manifest ", "error ", "info ", "2026-10-18 ", "INFO ",
+    "WARN ",   "{\"id\": ", "\"path\": ", "value, ", "return ", "static ", "const ", "\n",
+};
+
+}  // namespace
+
+CyberGenerator::CyberGenerator(Shape shape, size_t count, uint64_t seed) : shape(shape), count(count), state(seed) {}
+
+bool CyberGenerator::parseShape(const std::string& value, Shape& result) {
+  for (auto shape : {Shape::TINY, Shape::DEEP, Shape::HUGE, Shape::SPARSE, Shape::MIXED}) {
+    if (value == shapeName(shape)) {
+      result = shape;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* CyberGenerator::shapeName(Shape shape) noexcept {
+  switch (shape) {
+    case Shape::TINY:
+      return "tiny";
+    case Shape::DEEP:
+      return "deep";
+    case Shape::HUGE:
+      return "huge";
+    case Shape::SPARSE:
+      return "sparse";
+    case Shape::MIXED:
+      return "mixed";
+  }
+  return "";
+}
+
+size_t CyberGenerator::defaultCount(Shape shape) noexcept {
+  switch (shape) {
+    case Shape::TINY:
+      return 1'000'000;
+    case Shape::DEEP:
+      return 20'000;
+    case Shape::HUGE:
+      return 4;
+    case Shape::SPARSE:
+      return 16;
+    case Shape::MIXED:
+      return 100'000;
+  }
+  return 0;
+}
+
+uint64_t CyberGenerator::next() noexcept {
+  state += 0x9E3779B97F4A7C15ULL;
+  uint64_t mixed = state;
+  mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+  return mixed ^ (mixed >> 31);
+}
+
+uint64_t CyberGenerator::below(uint64_t limit) noexcept {
+  return limit == 0 ? 0 : next() % limit;
+}
+
+fs::path CyberGenerator::filePath(size_t ind) const {
+  auto name = std::to_string(ind);
+  switch (shape) {
+    case Shape::TINY:
+      return fs::path("d" + std::to_string(ind / 1'000'000)) / ("d" + std::to_string(ind / 1000 % 1000)) / ("f" + name);
+    case Shape::DEEP: {
+      fs::path result;
+      for (size_t level = 0; level <= ind % DEEP_LEVELS; ++level) {
+        result /= "d" + std::to_string(level);
+      }
+      return result / ("f" + name);
+    }
+    case Shape::HUGE:
+      return "huge" + name + ".bin";
+    case Shape::SPARSE:
+      return "sparse" + name + ".img";
+    case Shape::MIXED: {
+      static constexpr std::array<const char*, 4> EXTENSIONS = {".txt", ".log", ".bin", ".json"};
+      return fs::path("m" + std::to_string(ind % 7)) / ("s" + std::to_string(ind / 100 % 50)) /
+             ("f" + name + EXTENSIONS[ind % EXTENSIONS.size()]);
+    }
+  }
+  return name;
+}
+
+uint64_t CyberGenerator::fileSize(size_t ind) noexcept {
+  switch (shape) {
+    case Shape::TINY:
+      return (1 << 10) + below(3 << 10);
+    case Shape::DEEP:
+      return below(16 << 10);
+    case Shape::HUGE:
+      return HUGE_SIZE;
+    case Shape::SPARSE:
+      return SPARSE_SIZE;
+    case Shape::MIXED: {
+      auto kind = below(100);
+      if (kind < 90) {
+        return below(16 << 10);
+      }
+      if (kind < 99) {
+        return (64 << 10) + below(960 << 10);
+      }
+      return (4 << 20) + below(28 << 20);
+    }
+  }
+  return ind;
+}
+
+// Half of the files get log-like text, the other half random bytes, so compression has something to chew on.
+void CyberGenerator::writeFile(const fs::path& path, uint64_t size) {
+  thread_local std::vector<char> buffer(WRITE_SIZE);
+  auto file = CyberFile::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  bool text = (next() & 1) != 0;
+
+  for (uint64_t done = 0; done < size;) {
+    size_t chunk = std::min<uint64_t>(size - done, buffer.size());
+    size_t filled = 0;
+    if (text) {
+      while (filled < chunk) {
+        auto word = WORDS[next() & 15];
+        size_t part = std::min(word.size(), chunk - filled);
+        std::memcpy(buffer.data() + filled, word.data(), part);
+        filled += part;
+      }
+    } else {
+      for (; filled < chunk; filled += sizeof(uint64_t)) {
+        uint64_t value = next();
+        std::memcpy(buffer.data() + filled, &value, std::min(sizeof(value), chunk - filled));
+      }
+    }
+    file.write(buffer.data(), chunk);
+    done += chunk;
+  }
+}
+
+void CyberGenerator::writeSparse(const fs::path& path, uint64_t size) {
+  thread_local std::vector<char> buffer(SPARSE_ISLAND);
+  auto file = CyberFile::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (ftruncate(file.get(), static_cast<off_t>(size)) != 0) {
+    file.fail(errno, "truncate");
+  }
+  for (uint64_t offset = below(SPARSE_STEP); offset + buffer.size() <= size; offset += SPARSE_STEP) {
+    for (size_t pos = 0; pos < buffer.size(); pos += sizeof(uint64_t)) {
+      uint64_t value = next();
+      std::memcpy(buffer.data() + pos, &value, sizeof(value));
+    }
+    file.writeAt(buffer.data(), buffer.size(), static_cast<off_t>(offset));
+  }
+}
+
+CyberGenerator::Stats CyberGenerator::generate(const fs::path& root) {
+  fs::create_directories(root);
+  files.clear();
+
+  fs::path parent;
+  for (size_t ind = 0; ind < count; ++ind) {
+    auto path = root / filePath(ind);
+    if (path.parent_path() != parent) {
+      parent = path.parent_path();
+      fs::create_directories(parent);
+    }
+
+    auto size = fileSize(ind);
+    if (shape == Shape::SPARSE) {
+      writeSparse(path, size);
+    } else {
+      writeFile(path, size);
+    }
+    files.push_back(path);
+
+    if (shape == Shape::MIXED && ind % 100 == 0) {
+      fs::create_symlink(path.filename(), parent / ("link" + std::to_string(ind)));
+    }
+  }
+
+  return measure(root);
+}
+
+CyberGenerator::Stats CyberGenerator::mutate(const fs::path& root) {
+  if (files.empty()) {
+    return measure(root);
+  }
+
+  size_t modify = std::max<size_t>(1, files.size() / 100);
+  size_t remove = files.size() / 500;
+  size_t add = std::max<size_t>(1, files.size() / 200);
+
+  for (size_t ind = 0; ind < modify; ++ind) {
+    const auto& path = files[below(files.size())];
+    auto size = fs::file_size(path);
+    if (shape == Shape::SPARSE) {
+      std::vector<char> island(SPARSE_ISLAND, static_cast<char>(next()));
+      auto offset = static_cast<off_t>(below(size - island.size()));
+      CyberFile::open(path, O_WRONLY).writeAt(island.data(), island.size(), offset);
+    } else {
+      // Rewrite the file in place so its size changes too, like an edited document or a rotated log.
+      writeFile(path, size / 2 + below(size + 1));
+    }
+  }
+
+  for (size_t ind = 0; ind < remove && files.size() > 1; ++ind) {
+    auto pos = below(files.size());
+    fs::remove(files[pos]);
+    files[pos] = std::move(files.back());
+    files.pop_back();
+  }
+
+  for (size_t ind = 0; ind < add; ++ind) {
+    auto path = root / filePath(count);
+    fs::create_directories(path.parent_path());
+    auto size = fileSize(count++);
+    if (shape == Shape::SPARSE) {
+      writeSparse(path, size);
+    } else {
+      writeFile(path, size);
+    }
+    files.push_back(path);
+  }
+
+  return measure(root);
+}
+
+CyberGenerator::Stats CyberGenerator::measure(const fs::path& root) {
+  stats = {};
+  for (const auto& entry : fs::recursive_directory_iterator(root)) {
+    if (entry.is_symlink()) {
+      ++stats.files;
+    } else if (entry.is_directory()) {
+      ++stats.directories;
+    } else if (entry.is_regular_file()) {
+      ++stats.files;
+      stats.bytes += entry.file_size();
+    }
+  }
+  return stats;
+}
+
+}  // namespace nt
@@ -0,0 +1,66 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 18 October 2026, 10:15 AM
+ *  File    : CyberGenerator.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Deterministic synthetic source trees for cyber_bench. The same shape, count and seed always
+ * produce the same names, sizes and contents, and mutate() applies the same changes on top.
+ */
+class CyberGenerator {
+ public:
+  enum class Shape {
+    TINY,
+    DEEP,
+    HUGE,
+    SPARSE,
+    MIXED,
+  };
+
+  struct Stats {
+    size_t files = 0;
+    size_t directories = 0;
+    uint64_t bytes = 0;
+  };
+
+  CyberGenerator(Shape shape, size_t count, uint64_t seed);
+
+  Stats generate(const fs::path& root);
+  // Modifies about 1% of the files, deletes 0.2% and adds 0.5% new ones. Returns the new totals.
+  Stats mutate(const fs::path& root);
+
+  static bool parseShape(const std::string& value, Shape& shape);
+  static const char* shapeName(Shape shape) noexcept;
+  static size_t defaultCount(Shape shape) noexcept;
+
+ private:
+  Shape shape;
+  size_t count;
+  uint64_t state;
+  std::vector<fs::path> files;
+  Stats stats;
+
+  uint64_t next() noexcept;
+  uint64_t below(uint64_t limit) noexcept;
+
+  [[nodiscard]] fs::path filePath(size_t ind) const;
+  uint64_t fileSize(size_t ind) noexcept;
+  void writeFile(const fs::path& path, uint64_t size);
+  void writeSparse(const fs::path& path, uint64_t size);
+  Stats measure(const fs::path& root);
+};
+
+}  // namespace nt
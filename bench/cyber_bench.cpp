@@ -0,0 +1,453 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 18 October 2026, 11:30 AM
+ *  File    : cyber_bench.cpp
+ *  Project : Backup
+\******************************************/
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "../include/CyberBackup.hpp"
+#include "../include/CyberRestore.hpp"
+#include "CyberGenerator.hpp"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const char* const HELP =
+    "Usage: cyber_bench <WORKDIR> [OPERANDS]\n"
+    "Generate a synthetic source tree in WORKDIR and time a full backup, an incremental\n"
+    "backup after a small mutation and a restore of the latest backup. Results are JSON.\n\n"
+    "Operands:\n"
+    "  shape=<name>      tiny, deep, huge, sparse or mixed (default mixed)\n"
+    "  count=<n>         Number of generated files (default depends on the shape)\n"
+    "  seed=<n>          Generator seed (default 1)\n"
+    "  jobs=<n>          Passed to my_backup and my_restore\n"
+    "  backup=<operand>  Extra my_backup operand, may be repeated (e.g. backup=compress)\n"
+    "  restore=<operand> Extra my_restore operand, may be repeated\n"
+    "  output=<file>     Write the JSON report to file instead of stdout\n"
+    "  keep              Keep the generated trees and backups\n";
+
+struct Options {
+  fs::path workdir;
+  nt::CyberGenerator::Shape shape = nt::CyberGenerator::Shape::MIXED;
+  size_t count = 0;
+  uint64_t seed = 1;
+  std::string jobs;
+  std::vector<std::string> backup;
+  std::vector<std::string> restore;
+  fs::path output;
+  bool keep = false;
+};
+
+// What the launcher measures for one run of a tool and sends back as it is.
+struct Measure {
+  int exit_code = 0;
+  double wall_seconds = 0;
+  double user_seconds = 0;
+  double system_seconds = 0;
+  long peak_rss_kb = 0;
+  uint64_t io_syscalls = 0;
+};
+
+struct Result {
+  std::string name;
+  Measure measure;
+  nt::CyberGenerator::Stats stats;
+};
+
+/*
+ * Process forked before the source tree is generated which forks every tool run in turn. A child starts with
+ * the memory of its parent counted as resident, so running the tools from here keeps the heap of the bench,
+ * the generator and its tree out of their peak RSS. Requests and measures go through a pipe each way.
+ */
+class Launcher {
+ public:
+  Launcher();
+  Launcher(const Launcher&) = delete;
+  Launcher& operator=(const Launcher&) = delete;
+  ~Launcher();
+
+  Measure run(const std::string& tool, const std::vector<std::string>& args) const;
+
+ private:
+  pid_t pid = -1;
+  int requests = -1;
+  int replies = -1;
+
+  [[noreturn]] static void serve(int input, int output);
+};
+
+[[noreturn]] void fail(const std::string& message) {
+  std::cerr << "cyber_bench: " << message << '\n';
+  std::exit(EXIT_FAILURE);
+}
+
+uint64_t parseNumber(const std::string& value, const std::string& name) {
+  try {
+    size_t pos = 0;
+    auto result = std::stoull(value, &pos);
+    if (pos == value.size()) {
+      return result;
+    }
+  } catch (const std::exception&) {
+  }
+  fail("Invalid " + name + " '" + value + "'");
+}
+
+Options parseOptions(int argc, const char** argv) {
+  if (argc < 2 || std::string(argv[1]) == "help") {
+    std::cout << HELP;
+    std::exit(argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
+  Options options;
+  options.workdir = fs::absolute(argv[1]);
+  bool counted = false;
+  for (int ind = 2; ind < argc; ++ind) {
+    std::string arg = argv[ind];
+    if (arg.starts_with("shape=")) {
+      if (!nt::CyberGenerator::parseShape(arg.substr(6), options.shape)) {
+        fail("Unknown shape '" + arg.substr(6) + "'");
+      }
+    } else if (arg.starts_with("count=")) {
+      options.count = parseNumber(arg.substr(6), "count");
+      counted = true;
+    } else if (arg.starts_with("seed=")) {
+      options.seed = parseNumber(arg.substr(5), "seed");
+    } else if (arg.starts_with("jobs=")) {
+      options.jobs = arg;
+    } else if (arg.starts_with("backup=")) {
+      options.backup.push_back(arg.substr(7));
+    } else if (arg.starts_with("restore=")) {
+      options.restore.push_back(arg.substr(8));
+    } else if (arg.starts_with("output=")) {
+      options.output = arg.substr(7);
+    } else if (arg == "keep") {
+      options.keep = true;
+    } else {
+      fail("Wrong operand '" + arg + "'. Try 'cyber_bench help' for more information.");
+    }
+  }
+  if (!counted) {
+    options.count = nt::CyberGenerator::defaultCount(options.shape);
+  }
+  return options;
+}
+
+void writeAll(int fd, const void* data, size_t size) {
+  const auto* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    auto written = write(fd, bytes, size);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      fail("launcher pipe is broken");
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+  }
+}
+
+// False when the pipe is closed before the first byte.
+bool readAll(int fd, void* data, size_t size) {
+  auto* bytes = static_cast<char*>(data);
+  bool started = false;
+  while (size > 0) {
+    auto got = read(fd, bytes, size);
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      if (!started && got == 0) {
+        return false;
+      }
+      fail("launcher pipe is broken");
+    }
+    started = true;
+    bytes += got;
+    size -= static_cast<size_t>(got);
+  }
+  return true;
+}
+
+void writeStrings(int fd, const std::vector<std::string>& values) {
+  auto count = static_cast<uint32_t>(values.size());
+  writeAll(fd, &count, sizeof(count));
+  for (const auto& value : values) {
+    auto size = static_cast<uint32_t>(value.size());
+    writeAll(fd, &size, sizeof(size));
+    writeAll(fd, value.data(), value.size());
+  }
+}
+
+bool readStrings(int fd, std::vector<std::string>& values) {
+  uint32_t count = 0;
+  if (!readAll(fd, &count, sizeof(count))) {
+    return false;
+  }
+  values.assign(count, {});
+  for (auto& value : values) {
+    uint32_t size = 0;
+    if (!readAll(fd, &size, sizeof(size))) {
+      fail("launcher pipe is broken");
+    }
+    value.resize(size);
+    if (size != 0 && !readAll(fd, value.data(), size)) {
+      fail("launcher pipe is broken");
+    }
+  }
+  return true;
+}
+
+// Read and write syscalls of a finished child. It has to be read before the zombie is reaped.
+uint64_t readSyscalls(pid_t pid) {
+  std::ifstream io("/proc/" + std::to_string(pid) + "/io");
+  uint64_t result = 0;
+  std::string key;
+  uint64_t value = 0;
+  while (io >> key >> value) {
+    if (key == "syscr:" || key == "syscw:") {
+      result += value;
+    }
+  }
+  return result;
+}
+
+double toSeconds(const timeval& time) {
+  return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6;
+}
+
+// Backups are named after the current second, so two runs must never share one.
+void waitNextSecond() {
+  auto now = std::chrono::system_clock::now();
+  std::this_thread::sleep_until(std::chrono::ceil<std::chrono::seconds>(now) + std::chrono::milliseconds(10));
+}
+
+// argv[0] of the tool is args.front().
+template <typename Tool>
+Measure measure(const std::vector<std::string>& args) {
+  std::vector<const char*> argv;
+  for (const auto& arg : args) {
+    argv.push_back(arg.c_str());
+  }
+  argv.push_back(nullptr);
+
+  std::cout.flush();
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid < 0) {
+    fail("fork failed");
+  }
+  if (pid == 0) {
+    Tool(static_cast<int>(argv.size() - 1), argv.data()).process();
+    std::cout.flush();
+    _exit(EXIT_SUCCESS);
+  }
+
+  siginfo_t info{};
+  while (waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOWAIT) != 0 && errno == EINTR) {
+  }
+  auto finish = std::chrono::steady_clock::now();
+
+  Measure result;
+  result.io_syscalls = readSyscalls(pid);
+
+  int status = 0;
+  rusage usage{};
+  wait4(pid, &status, 0, &usage);
+  result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+  result.wall_seconds = std::chrono::duration<double>(finish - start).count();
+  result.user_seconds = toSeconds(usage.ru_utime);
+  result.system_seconds = toSeconds(usage.ru_stime);
+  result.peak_rss_kb = usage.ru_maxrss;
+  return result;
+}
+
+Launcher::Launcher() {
+  int down[2], up[2];
+  if (pipe(down) != 0 || pipe(up) != 0) {
+    fail("pipe failed");
+  }
+  std::cout.flush();
+  pid = fork();
+  if (pid < 0) {
+    fail("fork failed");
+  }
+  if (pid == 0) {
+    close(down[1]);
+    close(up[0]);
+    serve(down[0], up[1]);
+  }
+  close(down[0]);
+  close(up[1]);
+  requests = down[1];
+  replies = up[0];
+}
+
+Launcher::~Launcher() {
+  close(requests);
+  close(replies);
+  waitpid(pid, nullptr, 0);
+}
+
+Measure Launcher::run(const std::string& tool, const std::vector<std::string>& args) const {
+  std::vector<std::string> request = {tool};
+  request.insert(request.end(), args.begin(), args.end());
+  writeStrings(requests, request);
+  Measure result;
+  if (!readAll(replies, &result, sizeof(result))) {
+    fail("launcher exited");
+  }
+  return result;
+}
+
+// A request is the argv of a tool, starting with its name.
+void Launcher::serve(int input, int output) {
+  std::vector<std::string> request;
+  while (readStrings(input, request)) {
+    auto result = request.front() == "my_backup" ? measure<nt::CyberBackup>(request) : measure<nt::CyberRestore>(request);
+    writeAll(output, &result, sizeof(result));
+  }
+  _exit(EXIT_SUCCESS);
+}
+
+// Names of backups sort by time. Anything else in the destination, such as the chunk store, is skipped.
+fs::path latestBackup(const fs::path& root) {
+  fs::path result;
+  for (const auto& entry : fs::directory_iterator(root)) {
+    if (entry.is_directory() && nt::CyberBase::isTimestamp(entry.path().filename().string()) && entry.path() > result) {
+      result = entry.path();
+    }
+  }
+  return result;
+}
+
+// Relative path, type and size of every entry, which is what a restore has to reproduce.
+std::vector<std::tuple<std::string, int, uint64_t>> describeTree(const fs::path& root) {
+  std::vector<std::tuple<std::string, int, uint64_t>> result;
+  for (const auto& entry : fs::recursive_directory_iterator(root)) {
+    auto status = entry.symlink_status();
+    uint64_t size = fs::is_regular_file(status) ? entry.file_size() : 0;
+    result.emplace_back(fs::relative(entry.path(), root).string(), static_cast<int>(status.type()), size);
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+void writeResult(std::ostream& out, const Result& result) {
+  const auto& measure = result.measure;
+  auto seconds = std::max(measure.wall_seconds, 1e-9);
+  out << "    {\n"
+      << "      \"name\": \"" << result.name << "\",\n"
+      << "      \"exit_code\": " << measure.exit_code << ",\n"
+      << "      \"wall_seconds\": " << measure.wall_seconds << ",\n"
+      << "      \"files\": " << result.stats.files << ",\n"
+      << "      \"bytes\": " << result.stats.bytes << ",\n"
+      << "      \"files_per_second\": " << static_cast<double>(result.stats.files) / seconds << ",\n"
+      << "      \"mb_per_second\": " << static_cast<double>(result.stats.bytes) / seconds / (1 << 20) << ",\n"
+      << "      \"io_syscalls\": " << measure.io_syscalls << ",\n"
+      << "      \"syscalls_per_file\": "
+      << static_cast<double>(measure.io_syscalls) / static_cast<double>(std::max<size_t>(result.stats.files, 1)) << ",\n"
+      << "      \"peak_rss_kb\": " << measure.peak_rss_kb << ",\n"
+      << "      \"user_seconds\": " << measure.user_seconds << ",\n"
+      << "      \"system_seconds\": " << measure.system_seconds << "\n"
+      << "    }";
+}
+
+}  // namespace
+
+signed main(int argc, const char** argv) {
+  auto options = parseOptions(argc, argv);
+  auto source = options.workdir / "source";
+  auto backups = options.workdir / "backups";
+  auto restored = options.workdir / "restore";
+  for (const auto& path : {source, backups, restored}) {
+    fs::remove_all(path);
+  }
+  fs::create_directories(backups);
+  Launcher launcher;
+
+  nt::CyberGenerator generator(options.shape, options.count, options.seed);
+  auto generate_start = std::chrono::steady_clock::now();
+  auto generated = generator.generate(source);
+  auto generate_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - generate_start).count();
+
+  auto backupArgs = [&](const char* type) {
+    std::vector<std::string> args = {type, source.string(), backups.string(), "silent"};
+    if (!options.jobs.empty()) {
+      args.push_back(options.jobs);
+    }
+    args.insert(args.end(), options.backup.begin(), options.backup.end());
+    return args;
+  };
+
+  std::vector<Result> results;
+  waitNextSecond();
+  results.push_back({"full", launcher.run("my_backup", backupArgs("full")), generated});
+
+  auto mutated = generator.mutate(source);
+  waitNextSecond();
+  results.push_back({"incremental", launcher.run("my_backup", backupArgs("incremental")), mutated});
+
+  std::vector<std::string> restore_args = {latestBackup(backups).string(), restored.string(), "create", "silent"};
+  if (!options.jobs.empty()) {
+    restore_args.push_back(options.jobs);
+  }
+  restore_args.insert(restore_args.end(), options.restore.begin(), options.restore.end());
+  results.push_back({"restore", launcher.run("my_restore", restore_args), mutated});
+
+  bool matches = fs::exists(restored) && describeTree(source) == describeTree(restored);
+
+  std::ostringstream report;
+  report << std::fixed << std::setprecision(6);
+  report << "{\n"
+         << "  \"shape\": \"" << nt::CyberGenerator::shapeName(options.shape) << "\",\n"
+         << "  \"count\": " << options.count << ",\n"
+         << "  \"seed\": " << options.seed << ",\n"
+         << "  \"files\": " << generated.files << ",\n"
+         << "  \"directories\": " << generated.directories << ",\n"
+         << "  \"bytes\": " << generated.bytes << ",\n"
+         << "  \"generate_seconds\": " << generate_seconds << ",\n"
+         << "  \"restore_matches\": " << (matches ? "true" : "false") << ",\n"
+         << "  \"scenarios\": [\n";
+  for (size_t ind = 0; ind < results.size(); ++ind) {
+    writeResult(report, results[ind]);
+    report << (ind + 1 < results.size() ? ",\n" : "\n");
+  }
+  report << "  ]\n}\n";
+
+  if (options.output.empty()) {
+    std::cout << report.str();
+  } else {
+    std::ofstream(options.output) << report.str();
+  }
+
+  if (!options.keep) {
+    for (const auto& path : {source, backups, restored}) {
+      fs::remove_all(path);
+    }
+  }
+
+  bool failed = !matches || std::any_of(results.begin(), results.end(), [](const Result& result) {
+    return result.measure.exit_code != 0;
+  });
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
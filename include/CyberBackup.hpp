@@ -11,14 +11,72 @@
 
 namespace nt {
 
+class CyberJournal;
+class CyberManifest;
+class CyberPool;
+
 class CyberBackup : CyberBase {
  public:
   CyberBackup(int argc, const char** argv);
   void process() const noexcept final;
 
  private:
-  [[nodiscard]] std::pair<fs::path, std::string> findLastFull() const;
+  struct BackupInfo {
+    fs::path path;
+    std::string timestamp;
+    std::string type;
+  };
+
+  // First path of a hardlinked inode, kept while the rest of its group may still turn up in later batches.
+  struct Leader {
+    std::string path;
+    // One past its manifest index once written.
+    uint32_t record = 0;
+    bool followed = false;
+    bool stored = false;
+    bool tree = false;
+  };
+
+  // Backup holding the former copy of a changed file, which its delta is made against. A copy which is a delta
+  // itself stands for the basis it names.
+  struct Basis {
+    std::string origin;
+    bool delta = false;
+  };
+
+  static constexpr size_t BATCH = 16384;
+  static constexpr size_t QUEUE = 4;
+  // How often a watch drops changes which no backup can need any more.
+  static constexpr int64_t PRUNE_MS = 60'000;
+
+  // Synthesize shares the stored files by hardlink unless a copy mode has been asked for.
+  bool shared = true;
+  // Compared backups replay the journal of a running watch instead of walking the source.
+  bool journaled = false;
+
+  // Builds a full backup out of the last backup in destination and the backups it builds on.
+  void synthesize() const noexcept;
+  // Journals the changes to source in destination until it is stopped by SIGINT or SIGTERM.
+  void watch() const noexcept;
+  // Loads the journal for a backup on top of base which started at started, reason tells why it cannot be used.
+  bool openJournal(CyberJournal& journal, const fs::path& source_norm, const BackupInfo& base, int64_t started,
+                   std::string& reason) const;
+  [[nodiscard]] BackupInfo findLast(bool full_only) const;
+  void catalogBackup(const CyberCatalog::Record& record) const;
   static std::string getTime();
+  // Start of the backup named timestamp in nanoseconds since the epoch, rounded down to its second.
+  static int64_t parseTime(const std::string& timestamp);
+  static void matchManifest(const std::vector<CyberEntry>& entries, const CyberManifest& manifest, size_t& pos,
+                            std::vector<size_t>& matched, const std::function<void(std::string_view)>& deleted);
+  static void findBases(const std::vector<CyberEntry>& entries, const CyberManifest& manifest,
+                        const std::vector<size_t>& matched, const std::vector<char>& changed, const std::string& base,
+                        std::vector<Basis>& bases);
+  static size_t hashSuspects(std::vector<CyberEntry>& entries, const CyberManifest& manifest,
+                             const std::vector<size_t>& matched, const fs::path& root, CyberPool& pool,
+                             const CyberScheduler& scheduler);
+  static void compareManifest(std::vector<CyberEntry>& entries, const CyberManifest& manifest,
+                              const std::vector<size_t>& matched, const std::string& base, std::vector<char>& changed,
+                              std::vector<std::string>& origins);
 };
 
 }  // namespace nt
@@ -7,20 +7,38 @@
 
 #pragma once
 
+#include <atomic>
 #include <filesystem>
 #include <iostream>
-#include <regex>
+#include <mutex>
+#include <string_view>
+
+#include "CyberCatalog.hpp"
+#include "CyberChunk.hpp"
+#include "CyberCompress.hpp"
+#include "CyberCopy.hpp"
+#include "CyberDelta.hpp"
+#include "CyberLog.hpp"
+#include "CyberPack.hpp"
+#include "CyberScan.hpp"
+#include "CyberScheduler.hpp"
+#include "CyberStats.hpp"
 
 namespace nt {
 
 namespace fs = std::filesystem;
 
+class CyberManifest;
+
 class CyberBase {
  public:
   CyberBase() = default;
 
   virtual void process() const noexcept = 0;
 
+  // Whether value names a backup: YYYY-MM-DD_HH-MM-SS.
+  static bool isTimestamp(std::string_view value) noexcept;
+
  protected:
   enum class Parameter {
     CREATE_DESTINATION = 1,
@@ -32,30 +50,96 @@ class CyberBase {
     REMOVE_BASE = 64,
     REMOVE_INSIDE_ONLY = 128,
     OVERRIDE_DESTINATION = 256,
+    DEDUPLICATE = 512,
+    COMPRESS = 1024,
+    HASH = 2048,
+    PACK = 4096,
+    MERGE_DESTINATION = 8192,
+    DELTA = 16384,
   };
 
   std::string type;
   fs::path source;
   fs::path destination;
   int params = 0;
+  size_t jobs = 1;
+  CyberCopy copier;
+  CyberChunkStore chunks;
+  CyberCompressor compressor;
+  CyberDelta delta;
+  CyberPacker packer;
+  CyberStats stats;
+  CyberScheduler scheduler;
+  fs::path report;
+
+  // First error which ends the run, kept for the main thread while other threads still work. Pools given fatal
+  // drop the tasks they have not started once it is set.
+  struct Failure {
+    int code = 0;
+    std::string what;
+    std::string base;
+  };
+  mutable std::atomic<bool> fatal = false;
+  mutable std::mutex failure_mutex;
+  mutable Failure failure;
 
   static constexpr size_t MAX_STR = 75;
   static const char* DIR_NAME;
   static const char* SUM_NAME;
-  static const std::regex timestamp_pattern;
-
-  [[nodiscard]] std::string setStat(const fs::path& src, const fs::path& dst, const std::string& base = "") const;
-
-  static void printInfo(const std::vector<std::pair<fs::path, fs::path>>& info, const std::string& title,
-                        const std::string& empty);
+  static const char* MAN_NAME;
+  static const char* CHUNK_NAME;
+  static const char* PACK_NAME;
+  static const char* JOURNAL_NAME;
+  static const char* CATALOG_NAME;
+  static std::mutex output_mutex;
+
+  static void printInfo(const CyberLog& info, const std::string& title, const std::string& empty);
   static void abort(int code, const std::string& msg, int params = 0, const std::string& base = "");
   static std::string processFSError(const fs::filesystem_error& error, int params = static_cast<int>(Parameter::REMOVE_BASE),
                                     const std::string& base = "");
   static std::string processErrnoError(const fs::filesystem_error& error, int params = static_cast<int>(Parameter::REMOVE_BASE),
                                        const std::string& base = "");
   static std::string preparePathOutput(const fs::path& path);
+  static std::string describeFSError(const fs::filesystem_error& error);
+  // processFSError for code which runs next to other threads: instead of aborting, the first error keeps the failure
+  // for raiseFailure.
+  std::string reportFSError(const fs::filesystem_error& error, const std::string& base) const;
+  // Aborts with the kept failure, if any. Called on the main thread once no other thread is working.
+  void raiseFailure() const;
+
+  // Catalog of the backups in folder. One which does not exist yet is built from their summaries, and only kept in
+  // memory when it cannot be written.
+  static CyberCatalog openCatalog(const fs::path& folder);
+  // Adds a completed backup to the catalog of folder, false when it cannot.
+  static bool addToCatalog(const fs::path& folder, const CyberCatalog::Record& record);
+  static std::vector<CyberCatalog::Record> scanBackups(const fs::path& folder);
 
   static bool getParam(int value, Parameter param);
+  static size_t parseJobs(const std::string& value);
+  // A positive limit per second, with an optional K, M or G suffix for powers of 1024.
+  static uint64_t parseRate(const std::string& value);
+  static CyberCopy::Mode parseCopyMode(const std::string& value);
+  // Takes the operands of the scheduler: rate=, files=, io= and latency=. False for any other operand.
+  bool parseSchedule(const std::string& operand);
+  // Starts the scheduler for the device of path before any thread is, so they all share its priority. Only a
+  // priority it cannot set is reported.
+  void startScheduler(const fs::path& path);
+  // Index of path in entries sorted by CyberManifest::compare, entries.size() when it is missing.
+  static size_t findEntry(const std::vector<CyberEntry>& entries, std::string_view path);
+  // Paths a summary lists as deleted after its header, relative to the data folder and sorted like a manifest.
+  static std::vector<std::string> readDeleted(std::istream& sum_file, const std::string& base_timestamp);
+  // Tree of a backup without a chained manifest: its own data folder (layers[0]) laid over the one of its full
+  // backup (layers[1], if any) without the deleted paths. Entries name the layer holding them as their origin.
+  static std::vector<CyberEntry> mergeBackup(const std::vector<fs::path>& layers, const CyberManifest& manifest,
+                                             const std::vector<std::string>& deleted);
+  static std::vector<CyberEntry> mergeLayers(std::vector<CyberEntry>& upper, std::vector<CyberEntry>& lower,
+                                             const std::vector<std::string>& deleted);
+  static void applyStorage(std::vector<CyberEntry>& entries, const CyberManifest& manifest, uint16_t origin);
+
+  void writeReport(const std::string& tool, const std::string& kind, size_t errors) const;
+
+  template <typename T>
+  static void mergeResults(std::vector<T>& result, std::vector<std::vector<T>>& parts);
 
   template <typename... Args>
   static int nullifyParams(int value, Args... args);
@@ -64,8 +148,7 @@ class CyberBase {
   static int enableParams(int value, Args... args);
 
   template <typename Func, typename... Args>
-  void executeCopy(Func&& func, std::vector<std::pair<fs::path, fs::path>>& success,
-                   std::vector<std::pair<fs::path, fs::path>>& errors, const fs::path& entry, const fs::path& target_path,
+  bool executeCopy(Func&& func, CyberLog& success, CyberLog& errors, const fs::path& entry, const fs::path& target_path,
                    const fs::path& dst, bool modified, Args&&... args) const;
 };
 
@@ -79,25 +162,40 @@ int CyberBase::enableParams(int value, Args... args) {
   return (value | ... | static_cast<int>(args));
 }
 
+template <typename T>
+void CyberBase::mergeResults(std::vector<T>& result, std::vector<std::vector<T>>& parts) {
+  size_t total = result.size();
+  for (const auto& part : parts) {
+    total += part.size();
+  }
+  result.reserve(total);
+  for (auto& part : parts) {
+    std::move(part.begin(), part.end(), std::back_inserter(result));
+    part.clear();
+  }
+}
+
 template <typename Func, typename... Args>
-void CyberBase::executeCopy(Func&& func, std::vector<std::pair<fs::path, fs::path>>& success,
-                            std::vector<std::pair<fs::path, fs::path>>& errors, const fs::path& entry,
+bool CyberBase::executeCopy(Func&& func, CyberLog& success, CyberLog& errors, const fs::path& entry,
                             const fs::path& target_path, const fs::path& dst, bool modified, Args&&... args) const {
-  if (!modified) {
-    return;
+  if (!modified || fatal.load(std::memory_order_relaxed)) {
+    return false;
   }
 
   if (getParam(params, Parameter::PROCESS)) {
-    std::cout << preparePathOutput(entry) << "  -->  " << preparePathOutput(target_path) << std::endl;
+    std::lock_guard lock(output_mutex);
+    std::cout << preparePathOutput(entry) << "  -->  " << preparePathOutput(target_path) << '\n';
   }
 
   try {
     func(std::forward<Args>(args)...);
-    success.emplace_back(entry, target_path);
+    success.add(entry.native(), target_path.native());
+    return true;
   } catch (const fs::filesystem_error& error) {
-    auto what = processFSError(error, params, dst);
-    errors.emplace_back(entry, what);
+    auto what = reportFSError(error, dst);
+    errors.add(entry.native(), what);
   }
+  return false;
 }
 
 }  // namespace nt
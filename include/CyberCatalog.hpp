@@ -0,0 +1,68 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 7:30 PM
+ *  File    : CyberCatalog.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Append-only index of the backups in a destination, one text line per completed backup:
+ * id, type, base, status, entry and byte counts and the manifest path. A line goes in with one
+ * O_APPEND write, so tools running side by side never interleave theirs, and lookups read the
+ * file backwards from its end, where the latest backups are, instead of listing the destination.
+ */
+class CyberCatalog {
+ public:
+  struct Record {
+    std::string id;
+    std::string type;
+    std::string base;
+    std::string status;
+    // Entries of its manifest and bytes of the files it backed up, 0 for backups catalogued from their summary.
+    uint64_t entries = 0;
+    uint64_t bytes = 0;
+    // Relative to the destination, empty for backups without a manifest.
+    std::string manifest;
+  };
+
+  using Match = std::function<bool(const Record& record)>;
+
+  static constexpr const char* COMPLETE = "complete";
+  static constexpr size_t CHUNK = 64 << 10;
+
+  CyberCatalog() = default;
+  explicit CyberCatalog(fs::path path);
+
+  [[nodiscard]] bool exists() const;
+  // Creates the catalog holding records unless it exists already, returns whether it did. Readers only ever
+  // see it complete.
+  bool create(const std::vector<Record>& records) const;
+  void append(const Record& record) const;
+  // The newest record for which match holds. Without a catalog file, records set aside by setRecords are searched.
+  bool findLast(const Match& match, Record& found) const;
+  void setRecords(std::vector<Record> value);
+
+  [[nodiscard]] const fs::path& getPath() const noexcept;
+
+  static std::string format(const Record& record);
+  static bool parse(std::string_view line, Record& record);
+
+ private:
+  fs::path path;
+  std::vector<Record> records;
+};
+
+}  // namespace nt
@@ -0,0 +1,83 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 11:20 AM
+ *  File    : CyberChunk.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+
+#include "CyberFile.hpp"
+#include "CyberHash.hpp"
+#include "CyberScan.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Content-addressed chunk store shared by every backup of one destination.
+ * Files are cut with a FastCDC-style gear hash into variable-size chunks, each chunk is kept
+ * once as chunks/<2 hex>/<32 hex>, and the backup itself only keeps a recipe: the list of
+ * chunk digests and sizes that make up the file.
+ */
+class CyberChunkStore {
+ public:
+  struct Counters {
+    std::atomic<size_t> chunks = 0;
+    std::atomic<size_t> duplicates = 0;
+    std::atomic<uint64_t> bytes = 0;
+    std::atomic<uint64_t> stored_bytes = 0;
+  };
+
+  struct RecipeHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t size;
+    uint64_t count;
+  };
+
+  struct RecipeChunk {
+    uint64_t low;
+    uint64_t high;
+    uint32_t size;
+    uint32_t reserved;
+  };
+
+  static constexpr char MAGIC[4] = {'N', 'T', 'C', 'R'};
+  static constexpr uint32_t VERSION = 1;
+
+  static constexpr size_t MIN_CHUNK = 16 << 10;
+  static constexpr size_t AVG_CHUNK = 64 << 10;
+  static constexpr size_t MAX_CHUNK = 256 << 10;
+
+  CyberChunkStore() = default;
+  explicit CyberChunkStore(fs::path root);
+
+  void setRoot(const fs::path& value);
+  [[nodiscard]] const fs::path& getRoot() const noexcept;
+
+  void prepare() const;
+  void storeFile(const fs::path& src, const fs::path& recipe, const CyberEntry* stat = nullptr) const;
+  void restoreFile(const fs::path& recipe, const fs::path& dst, const CyberEntry* stat = nullptr) const;
+  // Hands the content of the file to sink chunk by chunk, every chunk checked against its digest. Returns its size.
+  uint64_t readFile(const fs::path& recipe, const CyberFile::Sink& sink) const;
+
+  [[nodiscard]] const Counters& getCounters() const noexcept;
+  [[nodiscard]] std::string describe() const;
+
+  static size_t findCut(const unsigned char* data, size_t size) noexcept;
+
+ private:
+  fs::path root;
+  mutable Counters counters;
+
+  [[nodiscard]] fs::path chunkPath(const CyberHash::Digest& digest) const;
+  void storeChunk(const CyberHash::Digest& digest, const unsigned char* data, size_t size) const;
+};
+
+}  // namespace nt
@@ -0,0 +1,85 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 3:10 PM
+ *  File    : CyberCompress.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "CyberFile.hpp"
+#include "CyberScan.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Block compression stage for regular files. A file is cut into independent BLOCK sized
+ * blocks, each packed with an LZ4-style byte-aligned LZ77 codec, and stored as
+ * Header, blocks, Block[count] index. Blocks are compressed and restored in parallel on
+ * the pool of the calling worker. Files which look already compressed are left alone.
+ */
+class CyberCompressor {
+ public:
+  struct Counters {
+    std::atomic<size_t> compressed = 0;
+    std::atomic<size_t> skipped = 0;
+    std::atomic<size_t> decompressed = 0;
+    std::atomic<uint64_t> bytes = 0;
+    std::atomic<uint64_t> stored_bytes = 0;
+  };
+
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t reserved;
+    uint64_t size;
+    uint64_t count;
+    uint64_t index_offset;
+  };
+
+  // A block whose stored size equals its raw size is kept uncompressed.
+  struct Block {
+    uint64_t offset;
+    uint32_t stored_size;
+    uint32_t raw_size;
+  };
+
+  static constexpr char MAGIC[4] = {'N', 'T', 'C', 'Z'};
+  static constexpr uint32_t VERSION = 1;
+
+  static constexpr size_t BLOCK = 256 << 10;
+  static constexpr size_t GROUP = 8;
+  static constexpr size_t MIN_SIZE = 1 << 10;
+  static constexpr size_t SAMPLE_SIZE = 64 << 10;
+  static constexpr double MAX_ENTROPY = 7.5;
+
+  // Returns false without creating dst when src is too small or does not look compressible.
+  bool compressFile(const fs::path& src, const fs::path& dst, const CyberEntry* stat = nullptr) const;
+  void decompressFile(const fs::path& src, const fs::path& dst, const CyberEntry* stat = nullptr) const;
+  // Hands the content of the file to sink in order, a group of blocks unpacked by the pool at a time. Returns its size.
+  uint64_t readFile(const fs::path& src, const CyberFile::Sink& sink) const;
+
+  [[nodiscard]] const Counters& getCounters() const noexcept;
+  [[nodiscard]] std::string describe() const;
+
+  static size_t bound(size_t size) noexcept;
+  static size_t compressBlock(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity) noexcept;
+  static bool decompressBlock(const unsigned char* src, size_t size, unsigned char* dst, size_t raw_size) noexcept;
+  static double entropy(const unsigned char* data, size_t size) noexcept;
+
+ private:
+  mutable Counters counters;
+
+  // Checked index of an opened file and the offset of every block in the content.
+  static std::vector<uint64_t> readIndex(const CyberFile& input, std::vector<Block>& index);
+};
+
+}  // namespace nt
@@ -0,0 +1,91 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 16 October 2026, 4:30 PM
+ *  File    : CyberCopy.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "CyberScan.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Regular file copy backend. In AUTO mode it tries a FICLONE reflink first, then an in-kernel
+ * copy_file_range and only then a userspace buffered loop; the other modes force one of them.
+ * Failures are reported as fs::filesystem_error, just like fs::copy.
+ * Sparse files are copied extent by extent (SEEK_DATA / SEEK_HOLE), so their holes stay holes.
+ * In AUTO mode batches of small files go through io_uring when the kernel allows it.
+ * Given an entry, copyFile also applies its owner, permissions and times to the open target.
+ * Given a pace, it is told of every chunk it has copied, which is then at most PACE_CHUNK.
+ */
+class CyberCopy {
+ public:
+  enum class Mode {
+    AUTO,
+    REFLINK,
+    KERNEL,
+    BUFFER,
+  };
+
+  struct Counters {
+    std::atomic<size_t> ring = 0;
+    std::atomic<size_t> reflink = 0;
+    std::atomic<size_t> kernel = 0;
+    std::atomic<size_t> buffer = 0;
+    std::atomic<size_t> sparse = 0;
+    std::atomic<uint64_t> bytes = 0;
+    std::atomic<uint64_t> holes = 0;
+  };
+
+  // One file of a batch. A nonzero result is the errno which stopped it, dst is then removed again.
+  struct Job {
+    fs::path src;
+    fs::path dst;
+    uint64_t size = 0;
+    uint32_t mode = 0;
+    int result = 0;
+  };
+
+  // Called with the bytes of each chunk once copied, may sleep to slow the copy down.
+  using Pace = std::function<void(uint64_t bytes)>;
+
+  static constexpr size_t RING_MAX = 64 << 10;
+  static constexpr size_t PACE_CHUNK = 8 << 20;
+  static constexpr size_t RING_BATCH = 32;
+
+  explicit CyberCopy(Mode mode = Mode::AUTO);
+
+  void copyFile(const fs::path& src, const fs::path& dst, const CyberEntry* stat = nullptr, const Pace& pace = {}) const;
+  // Copies jobs of at most RING_MAX bytes through io_uring. Returns false without touching anything if it is unavailable.
+  bool copyFiles(std::vector<Job>& jobs) const;
+  // False once copyFiles is known to return false, for the mode or because io_uring turned out to be unavailable.
+  [[nodiscard]] bool canBatch() const noexcept;
+
+  void setMode(Mode value) noexcept;
+  [[nodiscard]] Mode getMode() const noexcept;
+  [[nodiscard]] const Counters& getCounters() const noexcept;
+  [[nodiscard]] std::string describe() const;
+
+  static bool parseMode(const std::string& value, Mode& mode);
+
+ private:
+  Mode mode;
+  mutable Counters counters;
+
+  static bool copyReflink(int src_fd, int dst_fd);
+  static bool copyKernel(int src_fd, int dst_fd, uint64_t& copied, const Pace& pace);
+  static bool copyBuffer(int src_fd, int dst_fd, uint64_t& copied, const Pace& pace);
+  static bool copySparse(int src_fd, int dst_fd, uint64_t size, bool kernel, uint64_t& copied, const Pace& pace);
+};
+
+}  // namespace nt
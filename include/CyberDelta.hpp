@@ -0,0 +1,93 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 6:10 PM
+ *  File    : CyberDelta.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "CyberFile.hpp"
+#include "CyberScan.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * rsync-style delta encoding of a large file against its older copy (the basis) in another backup.
+ * The basis is cut into fixed blocks signed by a rolling weak checksum and a 128-bit CyberHash. The
+ * new file is searched byte by byte for those blocks and stored as Header, literal bytes, Op[count]:
+ * each op either copies a range of the basis or a range of the literals. The basis has to be a
+ * plain copy, so every delta is restored from one file it names by its backup.
+ */
+class CyberDelta {
+ public:
+  struct Counters {
+    std::atomic<size_t> encoded = 0;
+    std::atomic<size_t> skipped = 0;
+    std::atomic<size_t> decoded = 0;
+    std::atomic<uint64_t> bytes = 0;
+    std::atomic<uint64_t> matched_bytes = 0;
+    std::atomic<uint64_t> stored_bytes = 0;
+  };
+
+  static constexpr size_t NAME_SIZE = 32;
+
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t reserved;
+    uint64_t size;
+    uint64_t basis_size;
+    uint64_t count;
+    uint64_t index_offset;
+    // Timestamp of the backup holding the basis under the same path.
+    char basis[NAME_SIZE];
+  };
+
+  // Literal ops point into the delta file, every other op into the basis.
+  struct Op {
+    uint64_t offset;
+    uint64_t length;
+    uint32_t literal;
+    uint32_t reserved;
+  };
+
+  static constexpr char MAGIC[4] = {'N', 'T', 'C', 'D'};
+  static constexpr uint32_t VERSION = 1;
+
+  static constexpr size_t MIN_SIZE = 1 << 20;
+  static constexpr size_t MIN_BLOCK = 4 << 10;
+  static constexpr size_t MAX_BLOCK = 128 << 10;
+
+  // Returns false without creating dst when src is too small or less than half of it is found in basis.
+  bool encodeFile(const fs::path& src, const fs::path& basis, const std::string& basis_name, const fs::path& dst,
+                  const CyberEntry* stat = nullptr) const;
+  void decodeFile(const fs::path& src, const fs::path& basis, const fs::path& dst, const CyberEntry* stat = nullptr) const;
+  // Hands the content of the file to sink in order, read from the delta and basis a large range at a time. Returns its size.
+  uint64_t readFile(const fs::path& src, const fs::path& basis, const CyberFile::Sink& sink) const;
+
+  [[nodiscard]] const Counters& getCounters() const noexcept;
+  [[nodiscard]] std::string describe() const;
+
+  // Name of the backup holding the basis of the delta file at path.
+  static std::string basisOf(const fs::path& path);
+  // About the square root of size, like rsync, which balances the signature against what one changed byte costs.
+  static size_t blockSize(uint64_t size) noexcept;
+  static uint32_t checksum(const unsigned char* data, size_t size) noexcept;
+
+ private:
+  mutable Counters counters;
+
+  // Checked ops of an opened delta file, whose basis has to be of the size it was made against.
+  static std::vector<Op> readOps(const CyberFile& input, const CyberFile& reference);
+};
+
+}  // namespace nt
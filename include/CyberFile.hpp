@@ -0,0 +1,70 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 11:05 AM
+ *  File    : CyberFile.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <filesystem>
+#include <functional>
+
+#include "CyberScan.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Owning file descriptor. Every failing call throws fs::filesystem_error with the path the
+ * descriptor was opened with, so callers can run it inside executeCopy like any fs:: call.
+ */
+class CyberFile {
+ public:
+  // Receives the content of a stored file piece by piece, in order, from the readers of the stages.
+  using Sink = std::function<void(const unsigned char* data, size_t size)>;
+
+  CyberFile() = default;
+  CyberFile(int fd, fs::path path) noexcept;
+  CyberFile(CyberFile&& other) noexcept;
+  CyberFile& operator=(CyberFile&& other) noexcept;
+  CyberFile(const CyberFile&) = delete;
+  CyberFile& operator=(const CyberFile&) = delete;
+  ~CyberFile();
+
+  static CyberFile open(const fs::path& path, int flags, mode_t mode = 0600);
+
+  [[nodiscard]] int get() const noexcept;
+  [[nodiscard]] const fs::path& getPath() const noexcept;
+  [[nodiscard]] off_t size() const;
+
+  size_t read(void* data, size_t size) const;
+  size_t readAt(void* data, size_t size, off_t offset) const;
+  void write(const void* data, size_t size) const;
+  void writeAt(const void* data, size_t size, off_t offset) const;
+  // Leaves a hole instead of writing when data is all zeros. Returns whether anything was written;
+  // the file has to be resized to its full length afterwards in case it ends in a hole.
+  bool writeSparse(const void* data, size_t size, off_t offset) const;
+  void resize(off_t size) const;
+
+  // Owner, permissions and times of entry. All three are tried, the first failure is thrown.
+  void setStat(const CyberEntry& entry) const;
+  // A folder only gets its owner when created. A read-only mode would keep its contents from being written, so
+  // permissions and times come with setStat without owner once they are.
+  static void setOwner(const fs::path& path, const CyberEntry& entry);
+  static void setStat(const fs::path& path, const CyberEntry& entry, bool owner = true);
+
+  int release() noexcept;
+  void close() noexcept;
+
+  [[noreturn]] void fail(int code, const char* what) const;
+
+ private:
+  int fd = -1;
+  fs::path path;
+};
+
+}  // namespace nt
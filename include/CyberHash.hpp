@@ -0,0 +1,62 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 10:02 AM
+ *  File    : CyberHash.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Streaming 128-bit content hash. The input is consumed in 64-byte stripes by eight 64-bit lanes
+ * (multiply-accumulate with a rotating secret) and the lanes are scrambled after every 1 KiB block,
+ * the same structure as XXH3. It is fast and well distributed, but not cryptographic.
+ * Stripes are processed with AVX2 or NEON when available; every path yields the same digest.
+ */
+class CyberHash {
+ public:
+  struct Digest {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const Digest&) const = default;
+    [[nodiscard]] std::string hex() const;
+  };
+
+  static constexpr size_t LANES = 8;
+  static constexpr size_t STRIPE = 64;
+  static constexpr size_t STRIPES = 16;
+  static constexpr size_t BLOCK = STRIPE * STRIPES;
+
+  CyberHash() noexcept;
+
+  void update(const void* data, size_t size) noexcept;
+  [[nodiscard]] Digest digest() const noexcept;
+  // The 64 bits of digest() kept in the manifest, the way hashFile reports them.
+  [[nodiscard]] uint64_t value() const noexcept;
+
+  static Digest hash(const void* data, size_t size) noexcept;
+  // 64-bit content hash of a whole file as kept in the manifest. Never zero, which marks a missing hash.
+  static uint64_t hashFile(const fs::path& path);
+  static const char* backend() noexcept;
+
+ private:
+  uint64_t acc[LANES];
+  unsigned char buffer[BLOCK];
+  size_t buffered = 0;
+  uint64_t total = 0;
+
+  static void accumulate(uint64_t* lanes, const unsigned char* data, size_t stripes) noexcept;
+  static void scramble(uint64_t* lanes) noexcept;
+};
+
+}  // namespace nt
@@ -0,0 +1,80 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 4:15 PM
+ *  File    : CyberJournal.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "CyberScan.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+class CyberManifest;
+
+/*
+ * Paths of a source tree which changed while CyberWatch was running, each with the time of its last
+ * change. The journal is complete from since on and holds everything that happened before synced,
+ * so a backup whose base started after since can replay the tree from the base manifest and the
+ * journaled paths alone instead of walking it. A path flagged as tree has to be walked as a whole.
+ * It is kept sorted like a manifest and saved as text, one quoted path per line.
+ */
+class CyberJournal {
+ public:
+  struct Change {
+    int64_t time = 0;
+    bool tree = false;
+  };
+
+  static constexpr const char* MAGIC = "journal";
+  static constexpr uint32_t VERSION = 1;
+  // How often CyberWatch writes the journal, the time a backup waits at most for it to catch up.
+  static constexpr int FLUSH_MS = 1000;
+
+  CyberJournal() = default;
+  explicit CyberJournal(fs::path root);
+
+  bool load(const fs::path& path);
+  // The journal only replaces path once complete, readers never see a truncated one.
+  [[nodiscard]] bool save(const fs::path& path) const;
+
+  void record(std::string_view path, bool tree, int64_t time);
+  // Forgets every change, the journal is complete again from time on. Used when events were lost.
+  void reset(int64_t time);
+  // Drops changes from before time, no backup can build on a base that old any more.
+  void prune(int64_t time);
+  void setSynced(int64_t time) noexcept;
+
+  [[nodiscard]] const fs::path& getRoot() const noexcept;
+  [[nodiscard]] int64_t getSince() const noexcept;
+  [[nodiscard]] int64_t getSynced() const noexcept;
+  [[nodiscard]] size_t size() const noexcept;
+
+  // Visits the tree at root in manifest order like CyberScan::walk. Entries are taken from the manifest unless
+  // a change at or after from touched them, only those are looked at on disk, together with hardlinked files.
+  void walk(const CyberManifest& manifest, int64_t from, const CyberScan::Visitor& visit,
+            const CyberScan::Failure& failed = {}) const;
+
+  static int64_t now() noexcept;
+
+ private:
+  struct Less {
+    using is_transparent = void;
+    bool operator()(std::string_view lhs, std::string_view rhs) const noexcept;
+  };
+
+  fs::path root;
+  int64_t since = 0;
+  int64_t synced = 0;
+  std::map<std::string, Change, Less> changes;
+};
+
+}  // namespace nt
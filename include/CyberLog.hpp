@@ -0,0 +1,54 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 11:25 AM
+ *  File    : CyberLog.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "CyberFile.hpp"
+
+namespace nt {
+
+/*
+ * Append-only list of path pairs, the success and error lists of a run. Pairs are kept in a
+ * BUFFER sized block and spilled to an unlinked temporary file whenever it fills up, so a list
+ * costs the same memory however many entries it holds. add() is safe to call from many threads.
+ */
+class CyberLog {
+ public:
+  using Visitor = std::function<void(std::string_view first, std::string_view second)>;
+
+  static constexpr size_t BUFFER = 1 << 20;
+
+  CyberLog() = default;
+  CyberLog(const CyberLog&) = delete;
+  CyberLog& operator=(const CyberLog&) = delete;
+
+  void add(std::string_view first, std::string_view second);
+  // Calls visit for every pair in the order they were added.
+  void replay(const Visitor& visit) const;
+
+  [[nodiscard]] size_t size() const noexcept;
+  [[nodiscard]] bool empty() const noexcept;
+
+ private:
+  mutable std::mutex mutex;
+  CyberFile file;
+  std::string buffer;
+  uint64_t spilled = 0;
+  bool spill_failed = false;
+  std::atomic<size_t> count = 0;
+
+  void spill();
+  static size_t parse(std::string_view data, const Visitor& visit);
+};
+
+}  // namespace nt
@@ -0,0 +1,116 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 16 October 2026, 2:05 PM
+ *  File    : CyberManifest.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <fstream>
+#include <string_view>
+#include <utility>
+
+#include "CyberScan.hpp"
+
+namespace nt {
+
+/*
+ * Sorted binary list of every entry of the source at backup time.
+ * Layout: Header, Record[count], names blob, origins. Records are ordered by path
+ * component by component (see compare), so two manifests or a manifest and a
+ * sorted scan can be merge-joined without touching the old backup tree.
+ * Each record names the backup (origin) whose data folder holds its content,
+ * which makes the newest manifest of a chain enough to restore it.
+ * Further paths of a hardlinked file point at the first record of their inode instead.
+ */
+class CyberManifest {
+ public:
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+    uint64_t names_size;
+    uint64_t origins;
+  };
+
+  struct Record {
+    uint64_t name_offset;
+    uint64_t size;
+    int64_t mtime;
+    int64_t atime;
+    uint64_t hash;
+    uint32_t name_size;
+    uint32_t mode;
+    uint32_t uid;
+    uint32_t gid;
+    uint16_t origin;
+    uint8_t type;
+    uint8_t storage;
+    // One past the index of the record whose inode this one shares, 0 when it is not a further hardlink.
+    uint32_t link;
+  };
+
+  static constexpr char MAGIC[4] = {'N', 'T', 'M', 'F'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr size_t ORIGIN_SIZE = 32;
+
+  // Writes a manifest record by record in path order. Records are written aside right away and names
+  // to a file of their own, which finish() appends, so memory does not grow with the number of entries.
+  class Writer {
+   public:
+    Writer() = default;
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    ~Writer();
+
+    bool open(const fs::path& value);
+    // Link is one past the index of the first path of a hardlinked entry, 0 otherwise. Returns the index of entry.
+    size_t add(const CyberEntry& entry, uint32_t link = 0);
+    // The manifest only replaces path once complete, a crash never leaves a truncated one behind.
+    bool finish(const std::vector<std::string>& origins);
+
+   private:
+    fs::path path;
+    std::ofstream records;
+    std::fstream names;
+    uint64_t count = 0;
+    uint64_t names_size = 0;
+
+    [[nodiscard]] fs::path tempPath(const char* suffix) const;
+  };
+
+  CyberManifest() = default;
+  CyberManifest(const CyberManifest&) = delete;
+  CyberManifest& operator=(const CyberManifest&) = delete;
+  ~CyberManifest();
+
+  bool open(const fs::path& path);
+  void close() noexcept;
+
+  [[nodiscard]] bool isOpen() const noexcept;
+  [[nodiscard]] size_t size() const noexcept;
+  [[nodiscard]] const Record& record(size_t ind) const noexcept;
+  [[nodiscard]] std::string_view name(size_t ind) const noexcept;
+  [[nodiscard]] size_t find(std::string_view path) const noexcept;
+  // Records of path and everything below it, which form one run of the sorted manifest.
+  [[nodiscard]] std::pair<size_t, size_t> subtree(std::string_view path) const noexcept;
+  [[nodiscard]] size_t originCount() const noexcept;
+  [[nodiscard]] std::string_view origin(size_t ind) const noexcept;
+  [[nodiscard]] CyberEntry entry(size_t ind) const;
+
+  static int compare(std::string_view lhs, std::string_view rhs) noexcept;
+  static bool inside(std::string_view root, std::string_view path) noexcept;
+  static void sort(std::vector<CyberEntry>& entries);
+
+ private:
+  void* data = nullptr;
+  size_t data_size = 0;
+  const Record* records = nullptr;
+  const char* names = nullptr;
+  const char* origins = nullptr;
+  size_t count = 0;
+  size_t origin_count = 0;
+};
+
+}  // namespace nt
@@ -0,0 +1,121 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 18 October 2026, 5:05 PM
+ *  File    : CyberPack.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CyberFile.hpp"
+#include "CyberScan.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Packed storage for small files. Instead of one inode each, their contents are appended to
+ * large append-only segments: Header, file data back to back, Item[count] index, names blob.
+ * Every writer thread takes a segment of its own from a free list, so appends never share a
+ * buffer, and a segment is closed once it grows past SEGMENT_SIZE. Restore walks a segment
+ * front to back with WINDOW sized reads.
+ */
+class CyberPacker {
+ public:
+  struct Counters {
+    std::atomic<size_t> packed = 0;
+    std::atomic<size_t> unpacked = 0;
+    std::atomic<size_t> segments = 0;
+    std::atomic<uint64_t> bytes = 0;
+  };
+
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+    uint64_t index_offset;
+    uint64_t names_size;
+  };
+
+  // Owner, permissions and mtime make a segment readable without its manifest.
+  struct Item {
+    uint64_t offset;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t name_offset;
+    uint32_t name_size;
+    uint32_t mode;
+    uint32_t uid;
+    uint32_t gid;
+  };
+
+  using Visitor = std::function<void(const Item& item, std::string_view name, const unsigned char* data)>;
+
+  static constexpr char MAGIC[4] = {'N', 'T', 'P', 'K'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr const char* EXTENSION = ".pack";
+
+  static constexpr size_t MAX_SIZE = 64 << 10;
+  static constexpr uint64_t SEGMENT_SIZE = 256 << 20;
+  static constexpr size_t BUFFER = 4 << 20;
+  static constexpr size_t WINDOW = 8 << 20;
+
+  CyberPacker() = default;
+  CyberPacker(const CyberPacker&) = delete;
+  CyberPacker& operator=(const CyberPacker&) = delete;
+
+  // Creates the folder new segments go to. Needed before the first append only.
+  void prepare(const fs::path& value) const;
+
+  // Appends the file at src as entry.path. Safe to call from many threads at once.
+  void append(const fs::path& src, const CyberEntry& entry) const;
+  // Appends size bytes at data as entry.path, for files taken over from another segment.
+  void append(const CyberEntry& entry, const unsigned char* data, size_t size) const;
+  // Writes the index of every open segment. Nothing may be appended afterwards.
+  // Throws as well when a segment was lost earlier, since files reported as packed are then missing.
+  void finish() const;
+  // Calls visit for every file of the segment in file order.
+  void readSegment(const fs::path& segment, const Visitor& visit) const;
+
+  [[nodiscard]] const Counters& getCounters() const noexcept;
+  [[nodiscard]] std::string describe() const;
+
+  static std::vector<fs::path> listSegments(const fs::path& root);
+
+ private:
+  struct Segment {
+    CyberFile file;
+    uint64_t end = sizeof(Header);
+    std::vector<unsigned char> buffer;
+    std::vector<Item> items;
+    std::string names;
+  };
+
+  mutable fs::path root;
+  mutable std::mutex mutex;
+  mutable std::vector<std::unique_ptr<Segment>> idle;
+  mutable std::atomic<size_t> next = 0;
+  mutable std::atomic<bool> lost = false;
+  mutable Counters counters;
+
+  // Fills the buffer passed with at most size bytes of the file and returns how many it wrote.
+  using Filler = std::function<size_t(unsigned char* data, size_t size)>;
+
+  void store(const CyberEntry& entry, size_t size, const Filler& fill) const;
+  [[nodiscard]] std::unique_ptr<Segment> acquire() const;
+  void release(std::unique_ptr<Segment> segment) const;
+  static void flush(Segment& segment);
+  static void close(Segment& segment);
+};
+
+}  // namespace nt
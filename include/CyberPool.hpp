@@ -0,0 +1,69 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 16 October 2026, 10:12 AM
+ *  File    : CyberPool.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nt {
+
+/*
+ * Work-stealing thread pool. Every worker owns a deque: it pops its own tasks
+ * from the back and steals from the front of the others when it runs dry.
+ * Tasks receive the index of the worker that runs them, so callers can keep
+ * per-worker state without locking.
+ * split() lets a running task share a loop with the idle workers of its pool.
+ * Once cancelled is set, tasks not started yet are dropped, so wait() returns as
+ * soon as the running ones are done.
+ */
+class CyberPool {
+ public:
+  using Task = std::function<void(size_t)>;
+
+  explicit CyberPool(size_t jobs, const std::atomic<bool>* cancelled = nullptr);
+  CyberPool(const CyberPool&) = delete;
+  CyberPool& operator=(const CyberPool&) = delete;
+  ~CyberPool();
+
+  [[nodiscard]] size_t size() const noexcept;
+
+  void submit(Task task);
+  void wait();
+
+  static size_t defaultJobs() noexcept;
+  static void split(size_t count, const std::function<void(size_t)>& body);
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  const std::atomic<bool>* cancelled;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::atomic<size_t> queued = 0;
+  std::atomic<size_t> pending = 0;
+  std::atomic<size_t> next = 0;
+  bool stop = false;
+
+  bool pop(size_t ind, Task& task);
+  void run(size_t ind);
+};
+
+}  // namespace nt
@@ -0,0 +1,76 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 11:10 AM
+ *  File    : CyberQueue.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace nt {
+
+/*
+ * Bounded blocking queue between a producer and a consumer thread. push() waits while the
+ * queue is full, pop() waits while it is empty and returns false once it is closed and drained.
+ */
+template <typename T>
+class CyberQueue {
+ public:
+  explicit CyberQueue(size_t capacity);
+  CyberQueue(const CyberQueue&) = delete;
+  CyberQueue& operator=(const CyberQueue&) = delete;
+
+  void push(T value);
+  bool pop(T& value);
+  void close();
+
+ private:
+  size_t capacity;
+  bool closed = false;
+  std::deque<T> items;
+  std::mutex mutex;
+  std::condition_variable not_full;
+  std::condition_variable not_empty;
+};
+
+template <typename T>
+CyberQueue<T>::CyberQueue(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+template <typename T>
+void CyberQueue<T>::push(T value) {
+  std::unique_lock lock(mutex);
+  not_full.wait(lock, [this] { return items.size() < capacity || closed; });
+  if (closed) {
+    return;
+  }
+  items.push_back(std::move(value));
+  not_empty.notify_one();
+}
+
+template <typename T>
+bool CyberQueue<T>::pop(T& value) {
+  std::unique_lock lock(mutex);
+  not_empty.wait(lock, [this] { return !items.empty() || closed; });
+  if (items.empty()) {
+    return false;
+  }
+  value = std::move(items.front());
+  items.pop_front();
+  not_full.notify_one();
+  return true;
+}
+
+template <typename T>
+void CyberQueue<T>::close() {
+  std::lock_guard lock(mutex);
+  closed = true;
+  not_full.notify_all();
+  not_empty.notify_all();
+}
+
+}  // namespace nt
@@ -10,12 +10,27 @@
 #include "CyberBase.hpp"
 
 namespace nt {
+
 class CyberRestore : protected CyberBase {
  public:
   CyberRestore(int argc, const char** argv);
   void process() const noexcept final;
 
  private:
+  // Relative path of the only file or folder to restore, empty for the whole backup.
+  std::string selected;
+  // my_restore verify reads the backup back and checks it against its manifest instead of restoring it.
+  bool verifying = false;
+
+  static constexpr size_t BATCH = 16384;
+  static constexpr size_t VERIFY_BLOCK = 8 << 20;
+
+  // Entries [first, last) of the selection, manifest indices of a chained backup or else indices into merged,
+  // which is filled from the layers. Their totals go to the stats.
+  std::pair<size_t, size_t> selectEntries(const std::vector<fs::path>& layers, const CyberManifest& manifest, bool chained,
+                                          const std::vector<std::string>& deleted, std::vector<CyberEntry>& merged) const;
+  void verify(const fs::path& source_norm, const std::vector<fs::path>& layers, const CyberManifest& manifest, bool chained,
+              const std::vector<std::string>& deleted, const std::string& backup_type) const noexcept;
 };
 
 }  // namespace nt
@@ -0,0 +1,81 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 5:40 PM
+ *  File    : CyberRing.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+
+namespace nt {
+
+/*
+ * Minimal io_uring instance driven through raw syscalls, with a sparse table of
+ * registered files so linked requests can hand descriptors to each other.
+ * A ring which cannot be set up (old kernel, seccomp) just reports !isOpen().
+ */
+class CyberRing {
+ public:
+  CyberRing(unsigned entries, unsigned files) noexcept;
+  CyberRing(const CyberRing&) = delete;
+  CyberRing& operator=(const CyberRing&) = delete;
+  ~CyberRing();
+
+  [[nodiscard]] bool isOpen() const noexcept;
+  // Number of submission entries which can be prepared at once.
+  [[nodiscard]] unsigned capacity() const noexcept;
+
+  // Returns a zeroed submission entry or nullptr when the queue is full.
+  io_uring_sqe* prepare() noexcept;
+  // Submits everything prepared and blocks until at least wait completions are posted. Returns -errno on failure.
+  int submit(unsigned wait) noexcept;
+  // Takes back everything prepared or submitted which the kernel has not consumed yet and returns how many entries
+  // that was. The kernel only reads the queue inside io_uring_enter, so nothing races with it.
+  unsigned discard() noexcept;
+
+  template <typename Func>
+  size_t reap(Func&& func) noexcept;
+
+ private:
+  int fd = -1;
+  void* sq_ring = nullptr;
+  void* cq_ring = nullptr;
+  io_uring_sqe* sqes = nullptr;
+  size_t sq_ring_size = 0;
+  size_t cq_ring_size = 0;
+  size_t sqes_size = 0;
+
+  unsigned* sq_head = nullptr;
+  unsigned* sq_tail = nullptr;
+  unsigned* sq_array = nullptr;
+  unsigned sq_mask = 0;
+  unsigned sq_entries = 0;
+  unsigned* cq_head = nullptr;
+  unsigned* cq_tail = nullptr;
+  io_uring_cqe* cqes = nullptr;
+  unsigned cq_mask = 0;
+
+  unsigned prepared = 0;
+
+  void release() noexcept;
+  [[nodiscard]] unsigned loadTail() const noexcept;
+  void storeHead(unsigned value) noexcept;
+};
+
+template <typename Func>
+size_t CyberRing::reap(Func&& func) noexcept {
+  unsigned head = *cq_head;
+  unsigned tail = loadTail();
+  for (unsigned ind = head; ind != tail; ++ind) {
+    const auto& cqe = cqes[ind & cq_mask];
+    func(cqe.user_data, cqe.res);
+  }
+  storeHead(tail);
+  return tail - head;
+}
+
+}  // namespace nt
@@ -0,0 +1,81 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 16 October 2026, 11:40 AM
+ *  File    : CyberScan.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Everything the tools need to know about one entry, captured by a single statx call.
+ * Symlinks are never followed, so a link to a directory is reported as a link.
+ */
+struct CyberEntry {
+  enum class Type : uint8_t {
+    NONE = 0,
+    FILE = 1,
+    DIRECTORY = 2,
+    SYMLINK = 3,
+    OTHER = 4,
+  };
+
+  // How the backup keeps the data of a regular file.
+  enum class Storage : uint8_t {
+    PLAIN = 0,
+    CHUNKED = 1,
+    COMPRESSED = 2,
+    PACKED = 3,
+    DELTA = 4,
+  };
+
+  std::string path;
+  Type type = Type::NONE;
+  Storage storage = Storage::PLAIN;
+  uint16_t origin = 0;
+  uint32_t mode = 0;
+  uint32_t uid = 0;
+  uint32_t gid = 0;
+  uint32_t nlink = 0;
+  uint64_t size = 0;
+  uint64_t device = 0;
+  uint64_t inode = 0;
+  int64_t atime = 0;
+  int64_t mtime = 0;
+  // Content hash of a regular file (CyberHash::hashFile), 0 while it is unknown.
+  uint64_t hash = 0;
+  // Path of the first entry sharing the inode of this hardlinked file, empty for every other entry.
+  std::string link;
+
+  [[nodiscard]] bool isDirectory() const noexcept;
+  [[nodiscard]] bool isSymlink() const noexcept;
+  [[nodiscard]] bool isFile() const noexcept;
+};
+
+/*
+ * Tree walk in manifest order: depth first with the names of every folder sorted, which puts each
+ * folder right before its own subtree exactly like CyberManifest::compare. Only the folders on the
+ * way down are held at a time, so walk() runs in memory bounded by depth and folder width.
+ */
+class CyberScan {
+ public:
+  using Visitor = std::function<void(CyberEntry&& entry)>;
+  using Failure = std::function<void(const fs::filesystem_error& error)>;
+
+  static bool stat(const fs::path& path, CyberEntry& entry) noexcept;
+  // A folder which cannot be listed is still visited itself, failed is told about its contents.
+  static void walk(const fs::path& root, const Visitor& visit, const Failure& failed = {});
+  static std::vector<CyberEntry> scan(const fs::path& root);
+};
+
+}  // namespace nt
@@ -0,0 +1,121 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 9:15 PM
+ *  File    : CyberScheduler.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+#include "CyberThrottle.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * I/O scheduler of the copy path. Every file is admitted before it is read: it waits for a token
+ * bucket of files per second and one of bytes per second and, when adapting, for one of limit
+ * slots. The limit is halved whenever the read latency of the device under the source goes above
+ * the threshold and grows back by one slot per PERIOD while it stays below half of it. start() also
+ * moves the calling thread, and so every thread it starts afterwards, into an I/O priority class.
+ */
+class CyberScheduler {
+ public:
+  enum class Priority {
+    DEFAULT,
+    BEST_EFFORT,
+    IDLE,
+  };
+
+  struct Counters {
+    std::atomic<size_t> admitted = 0;
+    std::atomic<size_t> backoffs = 0;
+    std::atomic<size_t> lowest = 0;
+    // Read latency in nanoseconds over the last PERIOD that saw any reads.
+    std::atomic<uint64_t> latency = 0;
+  };
+
+  // Holds its slot while the file is read and gives it back when destroyed.
+  class Slot {
+   public:
+    Slot() = default;
+    Slot(Slot&& other) noexcept;
+    Slot& operator=(Slot&& other) noexcept;
+    Slot(const Slot&) = delete;
+    Slot& operator=(const Slot&) = delete;
+    ~Slot();
+
+   private:
+    friend class CyberScheduler;
+    Slot(const CyberScheduler* scheduler, uint64_t bytes) noexcept;
+
+    const CyberScheduler* scheduler = nullptr;
+    uint64_t bytes = 0;
+    uint64_t start = 0;
+  };
+
+  static constexpr uint64_t PERIOD = 500'000'000;
+  // Without device statistics the latency is sampled from files read in one go, up to this size.
+  static constexpr uint64_t SAMPLE_SIZE = 64 << 10;
+  static constexpr int LOWEST_LEVEL = 7;
+
+  CyberScheduler() = default;
+  CyberScheduler(const CyberScheduler&) = delete;
+  CyberScheduler& operator=(const CyberScheduler&) = delete;
+
+  void setBytesRate(uint64_t value) noexcept;
+  void setFilesRate(uint64_t value) noexcept;
+  void setPriority(Priority value, int value_level) noexcept;
+  // Read latency in nanoseconds to keep the source under by backing off concurrency, 0 for none.
+  void setLatency(uint64_t value) noexcept;
+
+  // Applies the priority and watches the device of path, allowing up to jobs files to be read at once. Throws
+  // fs::filesystem_error when the priority cannot be set, everything else is in place by then.
+  void start(const fs::path& path, size_t jobs);
+
+  // Streamed bytes are not paid for up front but through take() as they are read.
+  [[nodiscard]] Slot admit(uint64_t files, uint64_t bytes, bool streamed = false) const;
+  void take(uint64_t bytes) const;
+  // Pays for files already read under a slot admitted with nothing to pay, so only what was read is charged.
+  void charge(uint64_t files, uint64_t bytes) const;
+
+  [[nodiscard]] const Counters& getCounters() const noexcept;
+  [[nodiscard]] std::string describe() const;
+
+  // Parses idle, best-effort or best-effort:<0-7>, best-effort alone stands for the lowest level.
+  static bool parsePriority(const std::string& value, Priority& priority, int& level);
+
+ private:
+  CyberThrottle files_limit;
+  CyberThrottle bytes_limit;
+  Priority priority = Priority::DEFAULT;
+  int level = LOWEST_LEVEL;
+  uint64_t latency = 0;
+  size_t jobs = 1;
+  fs::path device_stat;
+
+  mutable std::mutex mutex;
+  mutable std::condition_variable freed;
+  mutable size_t active = 0;
+  mutable size_t limit = 1;
+  // Reads completed and milliseconds spent on them by the device at the last check.
+  mutable uint64_t device_reads = 0;
+  mutable uint64_t device_ticks = 0;
+  mutable std::atomic<uint64_t> next_check = 0;
+  mutable std::atomic<uint64_t> sampled = 0;
+  mutable std::atomic<uint64_t> sampled_time = 0;
+  mutable Counters counters;
+
+  void release(uint64_t bytes, uint64_t elapsed) const noexcept;
+  void adapt() const noexcept;
+  bool readDevice(uint64_t& reads, uint64_t& ticks) const noexcept;
+};
+
+}  // namespace nt
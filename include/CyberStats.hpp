@@ -0,0 +1,96 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 18 October 2026, 2:20 PM
+ *  File    : CyberStats.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "CyberScan.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Run instrumentation: phase timers, relaxed atomic counters and log2 histograms of file size
+ * and per-file copy latency. Workers call record() once per entry; when the progress line is
+ * enabled it is redrawn from there at most every PROGRESS_PERIOD with one write to stderr.
+ */
+class CyberStats {
+ public:
+  enum class Phase {
+    SCAN,
+    COMPARE,
+    COPY,
+    METADATA,
+    SUMMARY,
+    DELETION,
+    COUNT,
+  };
+
+  // Adds the time since construction to its phase when stopped or destroyed.
+  class Timer {
+   public:
+    Timer(const CyberStats& stats, Phase phase) noexcept;
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+    ~Timer();
+
+    void stop() noexcept;
+
+   private:
+    const CyberStats* stats;
+    Phase phase;
+    uint64_t start;
+  };
+
+  static constexpr size_t BUCKETS = 65;
+  static constexpr uint64_t PROGRESS_PERIOD = 250'000'000;
+
+  struct Counters {
+    std::atomic<size_t> total_entries = 0;
+    std::atomic<uint64_t> total_bytes = 0;
+    std::atomic<size_t> entries = 0;
+    std::atomic<size_t> files = 0;
+    std::atomic<uint64_t> bytes = 0;
+    std::atomic<uint64_t> next_progress = 0;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Phase::COUNT)> phases{};
+    std::array<std::atomic<uint64_t>, BUCKETS> sizes{};
+    std::array<std::atomic<uint64_t>, BUCKETS> latencies{};
+  };
+
+  CyberStats() noexcept;
+
+  Timer time(Phase phase) const noexcept;
+  void addTime(Phase phase, uint64_t nanoseconds) const noexcept;
+
+  void setProgress(bool enable) noexcept;
+  void setTotal(size_t entries, uint64_t bytes) const noexcept;
+  // One processed entry. Copied regular files count towards the totals and both histograms.
+  void record(const CyberEntry& entry, bool copied, uint64_t nanoseconds) const noexcept;
+  void finishProgress() const noexcept;
+
+  [[nodiscard]] const Counters& getCounters() const noexcept;
+  [[nodiscard]] std::string describe() const;
+  bool writeReport(const fs::path& path, const std::string& tool, const std::string& type, size_t errors) const;
+
+  static uint64_t now() noexcept;
+  static const char* phaseName(Phase phase) noexcept;
+
+ private:
+  uint64_t started;
+  bool progress = false;
+  mutable Counters counters;
+
+  void drawProgress(uint64_t moment) const noexcept;
+};
+
+}  // namespace nt
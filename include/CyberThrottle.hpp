@@ -0,0 +1,40 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 8:20 PM
+ *  File    : CyberThrottle.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace nt {
+
+/*
+ * Token bucket shared by every worker of a run, holding BURST nanoseconds worth of the rate. It is
+ * kept as one timeline advancing at the rate: each take() books its units on it and sleeps until
+ * the booking is due, so the workers together never go faster than the rate, however many there are.
+ */
+class CyberThrottle {
+ public:
+  static constexpr uint64_t BURST = 100'000'000;
+
+  // Units per second, 0 for no limit.
+  void setRate(uint64_t value) noexcept;
+  [[nodiscard]] uint64_t getRate() const noexcept;
+
+  void take(uint64_t units) const;
+
+  // Nanoseconds spent sleeping by all callers.
+  [[nodiscard]] uint64_t getWaited() const noexcept;
+
+ private:
+  uint64_t rate = 0;
+  // Steady clock time in nanoseconds at which the next booking starts.
+  mutable std::atomic<uint64_t> due = 0;
+  mutable std::atomic<uint64_t> waited = 0;
+};
+
+}  // namespace nt
@@ -0,0 +1,70 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 4:40 PM
+ *  File    : CyberWatch.hpp
+ *  Project : Backup
+\******************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+#include "CyberJournal.hpp"
+
+namespace nt {
+
+namespace fs = std::filesystem;
+
+/*
+ * Change watcher feeding a CyberJournal. It marks the whole filesystem of the root through fanotify
+ * with FAN_REPORT_DFID_NAME and resolves the reported folder handles back to paths, which needs
+ * CAP_SYS_ADMIN. Without it, one inotify watch is placed on every folder of the tree. Folders which
+ * appear inside it are watched on the fly and journaled as trees, since their contents may predate
+ * the watch. Lost events (queue overflow) reset the journal.
+ */
+class CyberWatch {
+ public:
+  enum class Backend {
+    NONE,
+    FANOTIFY,
+    INOTIFY,
+  };
+
+  explicit CyberWatch(CyberJournal& journal);
+  CyberWatch(const CyberWatch&) = delete;
+  CyberWatch& operator=(const CyberWatch&) = delete;
+  ~CyberWatch();
+
+  // Starts watching the root of the journal. Throws fs::filesystem_error when no backend can.
+  void start();
+  // Journals every pending event, waiting at most timeout milliseconds for the first one.
+  void poll(int timeout);
+
+  [[nodiscard]] Backend getBackend() const noexcept;
+  [[nodiscard]] size_t getOverflows() const noexcept;
+  [[nodiscard]] std::string describe() const;
+
+ private:
+  CyberJournal& journal;
+  Backend backend = Backend::NONE;
+  int fd = -1;
+  int mount_fd = -1;
+  size_t events = 0;
+  size_t overflows = 0;
+  // Inotify watch descriptors and fanotify folder handles with the relative path they stand for.
+  std::unordered_map<int, std::string> watches;
+  std::unordered_map<std::string, std::string> handles;
+
+  bool startFanotify();
+  void startInotify();
+  void watchTree(const std::string& path);
+  void readFanotify();
+  void readInotify();
+  // Journals a change of name inside folder; a change to its list of names touches the folder itself too.
+  void note(const std::string& folder, std::string_view name, bool listing, bool tree);
+  void overflow();
+};
+
+}  // namespace nt
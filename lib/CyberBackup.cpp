@@ -7,12 +7,40 @@
 
 #include "../include/CyberBackup.hpp"
 
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <csignal>
 #include <fstream>
-#include <list>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <optional>
 #include <ranges>
+#include <thread>
+
+#include "../include/CyberFile.hpp"
+#include "../include/CyberHash.hpp"
+#include "../include/CyberJournal.hpp"
+#include "../include/CyberManifest.hpp"
+#include "../include/CyberPool.hpp"
+#include "../include/CyberQueue.hpp"
+#include "../include/CyberWatch.hpp"
 
 namespace nt {
 
+namespace {
+
+volatile std::sig_atomic_t watch_stop = 0;
+
+void stopWatch(int) {
+  watch_stop = 1;
+}
+
+}  // namespace
+
 CyberBackup::CyberBackup(int argc, const char** argv) {
   if (argc == 1) {
     abort(static_cast<int>(std::errc::invalid_argument), "Missing a backup type. Try 'my_backup help' for more information.");
@@ -22,9 +50,19 @@ CyberBackup::CyberBackup(int argc, const char** argv) {
   if (argc == 2 && type == "help") {
     std::cout << "Usage: my_backup [TYPE] [SOURCE] [DESTINATION] [OPTIONAL FLAGS]\n"
                  "A tool for creating a backup of your files and folders from SOURCE to DESTINATION in timestamp name folder.\n"
-                 "\nTwo backup types are available: full and incremental.\n"
+                 "\nFour backup types are available: full, incremental, chain and snapshot.\n"
                  "  full             creates a full backup copy of the SOURCE\n"
                  "  incremental      creates a copy of the SOURCE with differences between current state and last full backup\n"
+                 "  chain            creates a copy of the SOURCE with differences between current state and last backup\n"
+                 "  snapshot         creates a complete tree of the SOURCE, copies the differences to the last backup and\n"
+                 "                   hardlinks unchanged files to the backup holding them\n"
+                 "\nUsage: my_backup synthesize [DESTINATION] [OPTIONAL FLAGS]\n"
+                 "  synthesize       creates a full backup out of the last backup in DESTINATION and the backups it builds on,\n"
+                 "                   without reading any SOURCE. Files keep their storage and share the inode of the stored\n"
+                 "                   file where possible, copy=<MODE> makes them copies instead\n"
+                 "\nUsage: my_backup watch [SOURCE] [DESTINATION] [OPTIONAL FLAGS]\n"
+                 "  watch            keeps a journal of the changes to SOURCE in DESTINATION until it is stopped,\n"
+                 "                   which backups with the 'journal' operand replay instead of walking SOURCE\n"
                  "\nOptions\n"
                  "  create       Create a backup folder if it does not exist\n"
                  "  full_info    Display a backup information after process\n"
@@ -32,6 +70,23 @@ CyberBackup::CyberBackup(int argc, const char** argv) {
                  "  silent       Silent mode (do not show errors)\n"
                  "  process      Show progress status\n"
                  "  ignore       Continue backing up despite errors\n"
+                 "  jobs=<N>     Copy files with N threads (default: number of CPU cores)\n"
+                 "  copy=<MODE>  File copy mode: auto, reflink, kernel or buffer (default: auto)\n"
+                 "  dedup        Store files as content-defined chunks shared between all backups of DESTINATION\n"
+                 "  compress     Compress files in parallel blocks unless they look compressed already (ignored with dedup)\n"
+                 "  pack         Append small files to large segment files instead of creating one file each\n"
+                 "  delta        Store large changed files as block deltas against their copy in the base backup (ignored\n"
+                 "               with dedup)\n"
+                 "  hash         Store content hashes and skip files whose content matches the base despite new metadata\n"
+                 "  journal      Replay the journal of a running 'my_backup watch' instead of walking SOURCE (not for full)\n"
+                 "  progress     Show a live progress line with throughput and ETA on stderr\n"
+                 "  report=<FILE> Write phase timings, totals and size and latency histograms to FILE as JSON\n"
+                 "\nI/O scheduling of the reads of SOURCE\n"
+                 "  rate=<N>     Read at most N bytes per second, K, M or G for KiB, MiB or GiB (e.g. rate=100M)\n"
+                 "  files=<N>    Open at most N files per second\n"
+                 "  io=<CLASS>   I/O priority: idle, best-effort or best-effort:<0-7> (best-effort alone is level 7)\n"
+                 "  latency=<MS> Read fewer files at once while reads of the SOURCE device take longer than MS\n"
+                 "               milliseconds on average ('us' suffix for microseconds), more again once below half\n"
               << std::endl;
     std::exit(0);
   }
@@ -41,26 +96,42 @@ CyberBackup::CyberBackup(int argc, const char** argv) {
           "Use just 'my_backup help' without any extra arguments for more information.");
   }
 
-  if (argc >= 2 && type != "full" && type != "incremental") {
+  if (argc >= 2 && type != "full" && type != "incremental" && type != "chain" && type != "snapshot" &&
+      type != "synthesize" && type != "watch") {
     abort(static_cast<int>(std::errc::invalid_argument),
-          "Wrong backup type. Now are supported: 'full', 'incremental'. Try 'my_backup help' for more information.");
+          "Wrong backup type. Now are supported: 'full', 'incremental', 'chain', 'snapshot', 'synthesize', 'watch'. Try "
+          "'my_backup help' for more information.");
   }
 
+  // A synthetic full backup is made of the backups in DESTINATION alone, so it takes no SOURCE.
+  bool synthetic = type == "synthesize";
   if (argc == 2) {
     abort(static_cast<int>(std::errc::invalid_argument),
-          "Missing a path of the entity to backup. Try 'my_backup help' for more information.");
+          synthetic ? "Missing a destination path of the backups to synthesize. Try 'my_backup help' for more information."
+                    : "Missing a path of the entity to backup. Try 'my_backup help' for more information.");
   }
 
-  source = argv[2];
-  if (argc == 3) {
-    abort(static_cast<int>(std::errc::invalid_argument),
-          "Missing a destination path of the entity to backup. Try 'my_backup help' for more information.");
+  if (!synthetic) {
+    source = argv[2];
+    if (argc == 3) {
+      abort(static_cast<int>(std::errc::invalid_argument),
+            "Missing a destination path of the entity to backup. Try 'my_backup help' for more information.");
+    }
   }
 
-  destination = argv[3];
+  destination = argv[synthetic ? 2 : 3];
   params = static_cast<int>(Parameter::REMOVE_BASE);
-  for (int ind = 4; ind < argc; ++ind) {
-    if (std::string(argv[ind]) == "create") {
+  jobs = CyberPool::defaultJobs();
+  for (int ind = synthetic ? 3 : 4; ind < argc; ++ind) {
+    if (parseSchedule(argv[ind])) {
+      continue;
+    }
+    if (synthetic && (std::string(argv[ind]) == "create" || std::string(argv[ind]) == "dedup" ||
+                      std::string(argv[ind]) == "compress" || std::string(argv[ind]) == "pack" ||
+                      std::string(argv[ind]) == "hash" || std::string(argv[ind]) == "delta")) {
+      abort(static_cast<int>(std::errc::invalid_argument),
+            "Operand '" + std::string(argv[ind]) + "' does not apply to synthesize, files keep the storage they have.");
+    } else if (std::string(argv[ind]) == "create") {
       params = enableParams(params, Parameter::CREATE_DESTINATION);
     } else if (std::string(argv[ind]) == "ignore") {
       params = enableParams(params, Parameter::IGNORE_ERRORS);
@@ -72,11 +143,44 @@ CyberBackup::CyberBackup(int argc, const char** argv) {
       params = enableParams(params, Parameter::SILENT);
     } else if (std::string(argv[ind]) == "process") {
       params = enableParams(params, Parameter::PROCESS);
+    } else if (std::string(argv[ind]).starts_with("jobs=")) {
+      jobs = parseJobs(std::string(argv[ind]).substr(5));
+    } else if (std::string(argv[ind]).starts_with("copy=")) {
+      copier.setMode(parseCopyMode(std::string(argv[ind]).substr(5)));
+      shared = false;
+    } else if (std::string(argv[ind]) == "dedup") {
+      params = enableParams(params, Parameter::DEDUPLICATE);
+    } else if (std::string(argv[ind]) == "compress") {
+      params = enableParams(params, Parameter::COMPRESS);
+    } else if (std::string(argv[ind]) == "pack") {
+      params = enableParams(params, Parameter::PACK);
+    } else if (std::string(argv[ind]) == "hash") {
+      params = enableParams(params, Parameter::HASH);
+    } else if (std::string(argv[ind]) == "delta") {
+      params = enableParams(params, Parameter::DELTA);
+    } else if (std::string(argv[ind]) == "journal") {
+      journaled = true;
+    } else if (std::string(argv[ind]) == "progress") {
+      stats.setProgress(true);
+    } else if (std::string(argv[ind]).starts_with("report=")) {
+      report = std::string(argv[ind]).substr(7);
     } else {
       abort(static_cast<int>(std::errc::invalid_argument),
-            "Wrong operand. Did you mean 'create', 'full_info', 'error_info', 'silent', 'process' or 'ignore'?");
+            "Wrong operand '" + std::string(argv[ind]) + "'. Try 'my_backup help' for more information.");
     }
   }
+
+  chunks.setRoot(destination / CHUNK_NAME);
+  startScheduler(source);
+}
+
+void CyberBackup::catalogBackup(const CyberCatalog::Record& record) const {
+  // The backup is complete without it, later ones only miss it as their base until the catalog is rebuilt.
+  if (!addToCatalog(destination, record) && !getParam(params, Parameter::SILENT)) {
+    std::lock_guard lock(output_mutex);
+    std::cerr << "Cannot add backup " << record.id << " to the catalog (" << (destination / CATALOG_NAME).string()
+              << "). Remove it to have it rebuilt." << std::endl;
+  }
 }
 
 std::string CyberBackup::getTime() {
@@ -87,45 +191,184 @@ std::string CyberBackup::getTime() {
   return timestamp.str();
 }
 
-std::pair<fs::path, std::string> CyberBackup::findLastFull() const {
-  std::vector<fs::path> backup_dirs;
+int64_t CyberBackup::parseTime(const std::string& timestamp) {
+  std::tm time{};
+  std::istringstream input(timestamp);
+  input >> std::get_time(&time, "%Y-%m-%d_%H-%M-%S");
+  time.tm_isdst = -1;
+  return input.fail() ? 0 : static_cast<int64_t>(std::mktime(&time)) * 1'000'000'000;
+}
 
-  for (const auto& entry : fs::directory_iterator(destination)) {
-    if (entry.is_directory()) {
-      const auto& dir_name = entry.path().filename().string();
-      if (std::regex_match(dir_name, timestamp_pattern)) {
-        backup_dirs.push_back(entry.path());
-      }
+bool CyberBackup::openJournal(CyberJournal& journal, const fs::path& source_norm, const BackupInfo& base, int64_t started,
+                              std::string& reason) const {
+  auto path = destination / JOURNAL_NAME;
+  if (!journal.load(path)) {
+    reason = "there is no journal in " + destination.string();
+    return false;
+  }
+  if (journal.getRoot() != source_norm) {
+    reason = "the journal is kept for " + journal.getRoot().string();
+    return false;
+  }
+  // Lost events or a watch started later leave changes to the base unknown.
+  if (journal.getSince() >= parseTime(base.timestamp)) {
+    reason = "the journal is not complete since backup " + base.timestamp;
+    return false;
+  }
+
+  // The watch writes the journal every FLUSH_MS. Once it has synced after this backup started, it holds every
+  // change made before; a watch which is not running any more never gets there.
+  auto deadline = started + 3LL * CyberJournal::FLUSH_MS * 1'000'000;
+  while (journal.getSynced() < started) {
+    if (CyberJournal::now() > deadline) {
+      reason = "the watch keeping the journal is not running";
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(CyberJournal::FLUSH_MS / 10));
+    if (!journal.load(path)) {
+      reason = "the journal cannot be read";
+      return false;
     }
   }
+  return true;
+}
 
-  std::sort(backup_dirs.begin(), backup_dirs.end());
+void CyberBackup::matchManifest(const std::vector<CyberEntry>& entries, const CyberManifest& manifest, size_t& pos,
+                                std::vector<size_t>& matched, const std::function<void(std::string_view)>& deleted) {
+  // Both sides are in manifest order, so one cursor kept across batches merge-joins the whole scan with the manifest.
+  for (size_t ind = 0; ind < entries.size(); ++ind) {
+    while (pos < manifest.size() && CyberManifest::compare(manifest.name(pos), entries[ind].path) < 0) {
+      deleted(manifest.name(pos++));
+    }
+    if (pos < manifest.size() && manifest.name(pos) == entries[ind].path) {
+      matched[ind] = pos++;
+    }
+  }
+}
 
-  std::pair<fs::path, std::string> ret;
-  for (const auto& backup_dir : std::ranges::reverse_view(backup_dirs)) {
-    if (fs::exists(backup_dir / SUM_NAME)) {
-      std::ifstream sum_file(backup_dir / SUM_NAME);
-      std::string backup_type;
+void CyberBackup::compareManifest(std::vector<CyberEntry>& entries, const CyberManifest& manifest,
+                                  const std::vector<size_t>& matched, const std::string& base, std::vector<char>& changed,
+                                  std::vector<std::string>& origins) {
+  // Unchanged entries keep pointing at the backup which holds their data; manifests without origins hold it all in base.
+  // process() refuses a base with more origins than the new backup could index, so the index always fits.
+  auto find_origin = [&](std::string_view name) {
+    auto it = std::find(origins.begin(), origins.end(), name);
+    if (it == origins.end()) {
+      it = origins.emplace(origins.end(), name);
+    }
+    return static_cast<uint16_t>(it - origins.begin());
+  };
 
-      if (!sum_file.is_open() || !(sum_file >> backup_type) || backup_type != "full" || !(sum_file >> ret.second) ||
-          !std::regex_match(ret.second, timestamp_pattern)) {
-        continue;
-      }
+  for (size_t ind = 0; ind < entries.size(); ++ind) {
+    if (matched[ind] == manifest.size()) {
+      changed[ind] = 1;
+      continue;
+    }
+    auto& entry = entries[ind];
+    const auto& record = manifest.record(matched[ind]);
+    bool same_size = record.type == static_cast<uint8_t>(entry.type) && (entry.isDirectory() || record.size == entry.size);
+    changed[ind] = !same_size || record.mode != entry.mode || record.uid != entry.uid || record.gid != entry.gid ||
+                   record.mtime != entry.mtime;
+    // A file hashed up front keeps the data of the base when only its metadata moved; the manifest takes the new one.
+    if (changed[ind] != 0 && same_size && entry.hash != 0 && entry.hash == record.hash) {
+      changed[ind] = 0;
+    }
+    // Further hardlinks are linked to their first path again every time, and a former one has no data in its origin.
+    if (!entry.link.empty() || record.link != 0) {
+      changed[ind] = 1;
+    }
+    if (changed[ind] == 0) {
+      entry.origin = find_origin(manifest.originCount() != 0 ? manifest.origin(record.origin) : base);
+      entry.storage = static_cast<CyberEntry::Storage>(record.storage);
+      entry.hash = record.hash;
+    }
+  }
+}
 
-      ret.first = backup_dir;
-      break;
+void CyberBackup::findBases(const std::vector<CyberEntry>& entries, const CyberManifest& manifest,
+                            const std::vector<size_t>& matched, const std::vector<char>& changed, const std::string& base,
+                            std::vector<Basis>& bases) {
+  // Only a large file which was a file of its own in the base as well has a former copy worth a delta.
+  for (size_t ind = 0; ind < entries.size(); ++ind) {
+    const auto& entry = entries[ind];
+    if (changed[ind] == 0 || !entry.isFile() || !entry.link.empty() || entry.size < CyberDelta::MIN_SIZE ||
+        matched[ind] == manifest.size()) {
+      continue;
+    }
+    const auto& record = manifest.record(matched[ind]);
+    auto storage = static_cast<CyberEntry::Storage>(record.storage);
+    if (record.type != static_cast<uint8_t>(CyberEntry::Type::FILE) || record.link != 0 ||
+        (storage != CyberEntry::Storage::PLAIN && storage != CyberEntry::Storage::DELTA)) {
+      continue;
+    }
+    bases[ind] = {std::string(manifest.originCount() != 0 ? manifest.origin(record.origin) : base),
+                  storage == CyberEntry::Storage::DELTA};
+  }
+}
+
+size_t CyberBackup::hashSuspects(std::vector<CyberEntry>& entries, const CyberManifest& manifest,
+                                 const std::vector<size_t>& matched, const fs::path& root, CyberPool& pool,
+                                 const CyberScheduler& scheduler) {
+  // Only files with a stored hash, the same size and different metadata can turn out unchanged by content.
+  std::vector<size_t> suspects;
+  for (size_t ind = 0; ind < entries.size(); ++ind) {
+    const auto& entry = entries[ind];
+    if (!entry.isFile() || !entry.link.empty() || matched[ind] == manifest.size()) {
+      continue;
+    }
+    const auto& record = manifest.record(matched[ind]);
+    if (record.type == static_cast<uint8_t>(entry.type) && record.size == entry.size && record.hash != 0 &&
+        (record.mtime != entry.mtime || record.mode != entry.mode || record.uid != entry.uid || record.gid != entry.gid)) {
+      suspects.push_back(ind);
     }
   }
 
-  if (ret.second.empty()) {
+  // A file which cannot be read keeps no hash and is copied, so the copy reports the error.
+  for (const auto& ind : suspects) {
+    pool.submit([&, ind](size_t) {
+      auto slot = scheduler.admit(1, entries[ind].size);
+      try {
+        entries[ind].hash = CyberHash::hashFile(root / entries[ind].path);
+      } catch (const fs::filesystem_error&) {
+      }
+    });
+  }
+  pool.wait();
+
+  return suspects.size();
+}
+
+CyberBackup::BackupInfo CyberBackup::findLast(bool full_only) const {
+  // The newest backups are at the end of the catalog. One whose folder has gone since is skipped.
+  auto catalog = openCatalog(destination);
+  CyberCatalog::Record record;
+  bool found = catalog.findLast(
+      [&](const CyberCatalog::Record& item) {
+        std::error_code code;
+        return item.status == CyberCatalog::COMPLETE && (!full_only || item.type == "full") && isTimestamp(item.id) &&
+               fs::exists(destination / item.id / SUM_NAME, code);
+      },
+      record);
+
+  if (!found) {
     abort(static_cast<int>(std::errc::no_such_file_or_directory),
-          "Correct full backup has not been found, Try to create it first.");
+          std::string(full_only ? "Correct full backup" : "Correct backup") + " has not been found, Try to create it first.");
   }
 
-  return ret;
+  return {destination / record.id, record.id, record.type};
 }
 
 void CyberBackup::process() const noexcept {
+  if (type == "synthesize") {
+    synthesize();
+    return;
+  }
+  if (type == "watch") {
+    watch();
+    return;
+  }
+  auto started = CyberJournal::now();
+
   if (!fs::is_directory(source)) {
     abort(static_cast<int>(std::errc::no_such_file_or_directory),
           "Source entity (" + source.string() + ") does not exist. Please check source path.",
@@ -134,14 +377,10 @@ void CyberBackup::process() const noexcept {
 
   auto timestamp = getTime();
 
-  fs::path full_backup_norm;
-  std::string full_backup_timestamp;
-  if (type == "incremental") {
-    std::tie(full_backup_norm, full_backup_timestamp) = findLastFull();
-    full_backup_norm = fs::canonical(fs::absolute(full_backup_norm));
-  } else {
-    full_backup_norm = destination / timestamp;
-    full_backup_timestamp = timestamp;
+  BackupInfo base{destination / timestamp, timestamp, type};
+  if (type != "full") {
+    base = findLast(type == "incremental");
+    base.path = fs::canonical(fs::absolute(base.path));
   }
 
   if (!fs::is_directory(destination)) {
@@ -175,6 +414,22 @@ void CyberBackup::process() const noexcept {
     }
   }
 
+  if (getParam(params, Parameter::PACK)) {
+    try {
+      packer.prepare(destination / timestamp / PACK_NAME);
+    } catch (const fs::filesystem_error& error) {
+      processFSError(error, nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+    }
+  }
+
+  if (getParam(params, Parameter::DEDUPLICATE)) {
+    try {
+      chunks.prepare();
+    } catch (const fs::filesystem_error& error) {
+      processFSError(error, nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+    }
+  }
+
   if (!getParam(params, Parameter::SILENT)) {
     std::cout << "Backing up from " << source << " to " << destination << "..." << std::endl;
   }
@@ -186,95 +441,1053 @@ void CyberBackup::process() const noexcept {
   auto source_norm = fs::canonical(fs::absolute(source));
   auto destination_norm = fs::canonical(fs::absolute(destination)) / timestamp;
 
-  std::list<fs::path> list;
-  for (const auto& entry : fs::recursive_directory_iterator(source_norm)) {
-    if (fs::is_directory(entry.path())) {
-      list.push_front(entry.path());
+  // The summary is written next to its final name as deletions turn up. It only takes that name once the backup
+  // is complete, since an existing summary is what marks a backup usable.
+  auto sum_path = destination_norm / SUM_NAME;
+  auto sum_temp = sum_path;
+  sum_temp += ".tmp";
+  std::ofstream sum_file(sum_temp, std::ios::out);
+  if (!sum_file.is_open()) {
+    abort(static_cast<int>(std::errc::no_such_file_or_directory), "Cannot create summary file. Try to recreate backup.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS));
+  }
+  sum_file << type << " " << base.timestamp << "\n\n";
+
+  CyberManifest::Writer manifest;
+  if (!manifest.open(destination_norm / MAN_NAME)) {
+    abort(static_cast<int>(std::errc::io_error), "Cannot create manifest file. Try to recreate backup.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS));
+  }
+
+  // Full backups copy everything. Incrementals and chains merge-join the scan with the manifest of their base backup.
+  // An incremental falls back to comparing against the full backup tree entry by entry when the manifest is missing.
+  bool compared = type == "full";
+  bool snapshot = type == "snapshot";
+  std::vector<std::string> origins{timestamp};
+  CyberManifest base_manifest;
+  if (!compared) {
+    if (base_manifest.open(base.path / MAN_NAME) && (base_manifest.originCount() != 0 || base.type == "full")) {
+      compared = true;
+      // Records name their origin with 16 bits, and this backup goes first in front of every origin of its base.
+      if (base_manifest.originCount() > std::numeric_limits<uint16_t>::max()) {
+        abort(static_cast<int>(std::errc::value_too_large),
+              "Backup " + base.timestamp + " builds on too many backups to chain to. Try to create a full backup first.",
+              nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+      }
+    } else if (type == "chain" || type == "snapshot") {
+      abort(static_cast<int>(std::errc::no_such_file_or_directory),
+            "Backup " + base.timestamp + " has no manifest to chain to. Try to create a full backup first.",
+            nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
     } else {
-      list.push_back(entry.path());
+      base_manifest.close();
+      origins.push_back(base.timestamp);
     }
   }
 
-  std::vector<std::pair<fs::path, fs::path>> success, errors;
-  for (const auto& entry : list) {
-    auto relative_path = entry.string().substr(source_norm.string().size() + 1, entry.string().size());
-    auto target_path = destination_norm / DIR_NAME / relative_path;
-    auto full_backup_path = full_backup_norm / DIR_NAME / relative_path;
+  // A journal of every change since the base makes walking the source unnecessary, the base manifest knows the rest.
+  CyberJournal journal;
+  bool replayed = false;
+  if (journaled && compared && base_manifest.isOpen()) {
+    std::string reason;
+    replayed = openJournal(journal, source_norm, base, started, reason);
+    if (!replayed && !getParam(params, Parameter::SILENT)) {
+      std::lock_guard lock(output_mutex);
+      std::cerr << "Cannot use the journal, " << reason << ". Walking the whole source instead." << std::endl;
+    }
+  }
+
+  // Deleted paths are relative to the data folder of the base and sorted like the manifest, so restore merges them.
+  CyberLog success, errors;
+  auto note_deleted = [&](std::string_view path) {
+    sum_file << std::quoted(path) << '\n';
+    success.add((source_norm / path).native(), "DELETE");
+  };
+
+  // The walk runs ahead on a thread of its own and hands over batches in manifest order, at most QUEUE of them wait.
+  // Everything below holds one batch at a time, so memory does not grow with the size of the tree.
+  CyberQueue<std::vector<CyberEntry>> queue(QUEUE);
+  std::optional<fs::filesystem_error> scan_error;
+  std::thread scanner([&] {
+    auto scan_timer = stats.time(CyberStats::Phase::SCAN);
+    std::vector<CyberEntry> batch;
+    auto visit = [&](CyberEntry&& entry) {
+      batch.push_back(std::move(entry));
+      if (batch.size() == BATCH) {
+        queue.push(std::move(batch));
+        batch.clear();
+      }
+    };
+    auto failed = [&](const fs::filesystem_error& error) {
+      errors.add(error.path1().native(), reportFSError(error, destination / timestamp));
+    };
+    try {
+      if (replayed) {
+        journal.walk(base_manifest, parseTime(base.timestamp), visit, failed);
+      } else {
+        CyberScan::walk(source_norm, visit, failed);
+      }
+    } catch (const fs::filesystem_error& error) {
+      scan_error = error;
+    }
+    if (!batch.empty()) {
+      queue.push(std::move(batch));
+    }
+    queue.close();
+  });
+
+  std::vector<CyberEntry> entries;
+  std::vector<char> changed;
+  std::vector<Basis> bases;
+  std::vector<std::string> basis_origins;
+  std::atomic<size_t> hashed = 0;
+
+  // A basis which cannot be read any more only costs the delta, the file is stored whole instead.
+  bool deltas = compared && getParam(params, Parameter::DELTA) && !getParam(params, Parameter::DEDUPLICATE);
+  auto encode_delta = [&](Basis& basis, const fs::path& from, const fs::path& to, const CyberEntry& record) {
+    auto backups = destination_norm.parent_path();
+    try {
+      if (basis.delta) {
+        basis.origin = CyberDelta::basisOf(backups / basis.origin / DIR_NAME / record.path);
+        basis.delta = false;
+      }
+      return delta.encodeFile(from, backups / basis.origin / DIR_NAME / record.path, basis.origin, to, &record);
+    } catch (const fs::filesystem_error&) {
+      std::error_code code;
+      fs::remove(to, code);
+      return false;
+    }
+  };
+
+  auto backup_entry = [&](size_t ind, std::vector<size_t>& entry_copied, bool prepared = false, uint64_t shared = 0) {
+    auto started = CyberStats::now();
+    const auto& record = entries[ind];
+    auto entry = source_norm / record.path;
+    auto target_path = destination_norm / DIR_NAME / record.path;
+
+    if (!compared) {
+      CyberEntry base_record;
+      CyberScan::stat(base.path / DIR_NAME / record.path, base_record);
+
+      bool modified = record.type != base_record.type || record.mtime != base_record.mtime;
+      if (record.isSymlink()) {
+        std::error_code code;
+        modified = record.type != base_record.type ||
+                   fs::read_symlink(entry, code) != fs::read_symlink(base.path / DIR_NAME / record.path, code);
+      } else if (!record.isDirectory()) {
+        modified = modified || record.size != base_record.size;
+      }
+      changed[ind] = modified;
+      entries[ind].origin = modified ? 0 : 1;
+    }
+
+    bool modified = changed[ind] != 0;
+    bool copied = false;
+
+    // Small files go to a segment when packing and never get a path of their own in this backup.
+    bool packed = record.isFile() && record.size <= CyberPacker::MAX_SIZE && getParam(params, Parameter::PACK);
+
+    // Reading the source waits for the scheduler, which limits the rates and, when adapting, how many files are read
+    // at once. Plain copies pay for their bytes chunk by chunk, so a large file is paced as well, every other stage
+    // up front. Files a ring batch has copied already were paid for with it.
+    bool plain = record.isFile() && !packed && bases[ind].origin.empty() && !getParam(params, Parameter::DEDUPLICATE) &&
+                 !getParam(params, Parameter::COMPRESS) && !(record.hash == 0 && getParam(params, Parameter::HASH));
+    CyberScheduler::Slot slot;
+    if (modified && record.isFile() && !prepared) {
+      slot = scheduler.admit(1, record.size, plain);
+    }
+    auto pace = [this](uint64_t bytes) { scheduler.take(bytes); };
+
+    if (modified && record.isFile() && record.hash == 0 && getParam(params, Parameter::HASH)) {
+      try {
+        entries[ind].hash = CyberHash::hashFile(entry);
+        ++hashed;
+      } catch (const fs::filesystem_error&) {
+      }
+    }
+
+    // The parent of a changed entry may be unchanged itself and so missing from this backup.
+    if (modified && !prepared && !packed && !record.isDirectory()) {
+      std::error_code code;
+      fs::create_directories(target_path.parent_path(), code);
+    }
+
+    // Metadata is applied as part of each copy, only directory modes and times wait until their contents are written.
+    if (record.isDirectory()) {
+      copied = executeCopy(
+          [&record](const fs::path& to) {
+            fs::create_directories(to);
+            CyberFile::setOwner(to, record);
+          },
+          success, errors, entry, target_path, destination / timestamp, modified, target_path);
+
+    } else if (packed) {
+      copied = executeCopy([this, &record](const fs::path& from) { packer.append(from, record); }, success, errors, entry,
+                           target_path, destination / timestamp, modified, entry);
+      if (copied) {
+        entries[ind].storage = CyberEntry::Storage::PACKED;
+      }
 
-    bool modified = false;
+    } else if (record.isFile() && !bases[ind].origin.empty()) {
+      auto storage = CyberEntry::Storage::PLAIN;
+      copied = executeCopy(
+          [&](const fs::path& from, const fs::path& to) {
+            if (encode_delta(bases[ind], from, to, record)) {
+              storage = CyberEntry::Storage::DELTA;
+            } else if (getParam(params, Parameter::COMPRESS) && compressor.compressFile(from, to, &record)) {
+              storage = CyberEntry::Storage::COMPRESSED;
+            } else {
+              copier.copyFile(from, to, &record);
+            }
+          },
+          success, errors, entry, target_path, destination / timestamp, modified, entry, target_path);
+      if (copied) {
+        entries[ind].storage = storage;
+      }
 
-    if (fs::is_directory(entry)) {
-      modified = !fs::is_directory(full_backup_path) || fs::last_write_time(entry) != fs::last_write_time(full_backup_path);
-      executeCopy(static_cast<bool (*)(const fs::path&)>(fs::create_directories), success, errors, entry, target_path,
-                  destination / timestamp, modified, target_path);
+    } else if (record.isFile() && getParam(params, Parameter::DEDUPLICATE)) {
+      copied = executeCopy([this, &record](const fs::path& from, const fs::path& to) { chunks.storeFile(from, to, &record); },
+                           success, errors, entry, target_path, destination / timestamp, modified, entry, target_path);
+      if (copied) {
+        entries[ind].storage = CyberEntry::Storage::CHUNKED;
+      }
+
+    } else if (record.isFile() && getParam(params, Parameter::COMPRESS)) {
+      bool compressed = false;
+      copied = executeCopy(
+          [this, &record, &compressed](const fs::path& from, const fs::path& to) {
+            compressed = compressor.compressFile(from, to, &record);
+            if (!compressed) {
+              copier.copyFile(from, to, &record);
+            }
+          },
+          success, errors, entry, target_path, destination / timestamp, modified, entry, target_path);
+      if (copied && compressed) {
+        entries[ind].storage = CyberEntry::Storage::COMPRESSED;
+      }
 
-    } else if (fs::is_symlink(entry)) {
-      modified = !fs::is_symlink(full_backup_path) || (fs::read_symlink(entry) != fs::read_symlink(full_backup_path));
-      executeCopy(static_cast<void (*)(const fs::path&, const fs::path&, fs::copy_options)>(fs::copy), success, errors, entry,
-                  target_path, destination / timestamp, modified, entry, target_path, fs::copy_options::copy_symlinks);
+    } else if (record.isFile()) {
+      copied = executeCopy(
+          [this, &record, prepared, plain, &pace](const fs::path& from, const fs::path& to) {
+            if (prepared) {
+              CyberFile::setStat(to, record);
+            } else {
+              copier.copyFile(from, to, &record, plain ? CyberCopy::Pace(pace) : CyberCopy::Pace());
+            }
+          },
+          success, errors, entry, target_path, destination / timestamp, modified, entry, target_path);
 
     } else {
-      modified = !fs::exists(full_backup_path) || fs::last_write_time(entry) != fs::last_write_time(full_backup_path) ||
-                 fs::file_size(entry) != fs::file_size(full_backup_path);
-      executeCopy(static_cast<void (*)(const fs::path&, const fs::path&, fs::copy_options)>(fs::copy), success, errors, entry,
-                  target_path, destination / timestamp, modified, entry, target_path, fs::copy_options::copy_symlinks);
+      copied = executeCopy(
+          [&record](const fs::path& from, const fs::path& to) {
+            fs::copy(from, to, fs::copy_options::copy_symlinks);
+            if (!record.isSymlink()) {
+              CyberFile::setStat(to, record);
+            }
+          },
+          success, errors, entry, target_path, destination / timestamp, modified, entry, target_path);
+    }
+
+    if (copied) {
+      entry_copied.push_back(ind);
+    }
+    stats.record(record, copied, CyberStats::now() - started + shared);
+  };
+
+  // A snapshot holds the whole tree: unchanged files are linked to the backup holding them, which leaves the new one
+  // as their only origin. A file which cannot be linked is backed up from the source instead.
+  std::atomic<size_t> hardlinked = 0;
+  auto link_entry = [&](size_t ind, std::vector<size_t>& entry_copied) {
+    auto started = CyberStats::now();
+    auto& record = entries[ind];
+    std::error_code code;
+    fs::create_hard_link(destination_norm.parent_path() / origins[record.origin] / DIR_NAME / record.path,
+                         destination_norm / DIR_NAME / record.path, code);
+    record.origin = 0;
+    if (code) {
+      changed[ind] = 1;
+      record.storage = CyberEntry::Storage::PLAIN;
+      backup_entry(ind, entry_copied);
+      return;
+    }
+    ++hardlinked;
+    entry_copied.push_back(ind);
+    stats.record(record, false, CyberStats::now() - started);
+  };
+
+  // Folders created by this backup get their modes and times once the walk has left them and the copies inside are
+  // done, which also sets them bottom-up. Only the folders on the way down are kept open.
+  std::vector<CyberEntry> open_folders, closing;
+  auto close_folders = [&] {
+    auto metadata_timer = stats.time(CyberStats::Phase::METADATA);
+    for (const auto& record : closing) {
+      try {
+        CyberFile::setStat(destination_norm / DIR_NAME / record.path, record, false);
+      } catch (const fs::filesystem_error& error) {
+        errors.add((source_norm / record.path).native(), reportFSError(error, destination / timestamp));
+      }
+    }
+    closing.clear();
+  };
+
+  // The first path of every hardlinked inode seen so far. Its group may go on in any later batch.
+  std::map<std::pair<uint64_t, uint64_t>, Leader> leaders;
+  std::vector<Leader*> groups;
+  size_t link_groups = 0, linked = 0;
+
+  CyberPool pool(jobs, &fatal);
+  std::vector<std::vector<size_t>> pool_copied(pool.size());
+  // Small plain copies go out in batches through one ring; whatever the ring could not copy takes the usual path.
+  bool batched = compared && copier.canBatch() && !getParam(params, Parameter::DEDUPLICATE) &&
+                 !getParam(params, Parameter::COMPRESS) && !getParam(params, Parameter::PACK);
+
+  size_t manifest_pos = 0, total_entries = 0, recorded = 0;
+  uint64_t total_bytes = 0;
+  while (queue.pop(entries)) {
+    // After a failure the walk is only drained, the run ends once it is over.
+    if (fatal.load()) {
+      continue;
+    }
+    auto compare_timer = stats.time(CyberStats::Phase::COMPARE);
+    changed.assign(entries.size(), 1);
+    groups.assign(entries.size(), nullptr);
+    bases.assign(entries.size(), {});
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      auto& entry = entries[ind];
+      if (!entry.isFile() || entry.nlink < 2) {
+        continue;
+      }
+      auto [it, inserted] = leaders.try_emplace({entry.device, entry.inode}, Leader{entry.path});
+      if (!inserted) {
+        entry.link = it->second.path;
+        link_groups += it->second.followed ? 0 : 1;
+        it->second.followed = true;
+      }
+      groups[ind] = &it->second;
+    }
+
+    std::vector<size_t> matched(entries.size(), base_manifest.size());
+    if (base_manifest.isOpen()) {
+      matchManifest(entries, base_manifest, manifest_pos, matched, note_deleted);
+      if (getParam(params, Parameter::HASH)) {
+        hashed += hashSuspects(entries, base_manifest, matched, source_norm, pool, scheduler);
+      }
+      compareManifest(entries, base_manifest, matched, base.timestamp, changed, origins);
+    }
+    // Folders, symlinks and packed files have nothing in the tree to link to, a snapshot writes them again. So it
+    // does with deltas, whose basis only the manifests of their own chain name.
+    for (size_t ind = 0; snapshot && ind < entries.size(); ++ind) {
+      if (changed[ind] == 0 && (!entries[ind].isFile() || entries[ind].storage == CyberEntry::Storage::PACKED ||
+                                entries[ind].storage == CyberEntry::Storage::DELTA)) {
+        changed[ind] = 1;
+        entries[ind].storage = CyberEntry::Storage::PLAIN;
+        entries[ind].origin = 0;
+      }
+    }
+    if (deltas && base_manifest.isOpen()) {
+      findBases(entries, base_manifest, matched, changed, base.timestamp, bases);
+    }
+    compare_timer.stop();
+
+    total_entries += entries.size();
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      total_bytes += changed[ind] != 0 && entries[ind].isFile() && entries[ind].link.empty() ? entries[ind].size : 0;
+    }
+    stats.setTotal(total_entries, total_bytes);
+
+    // Directories are created up front on this thread, so every file task finds its parent in place.
+    auto copy_timer = stats.time(CyberStats::Phase::COPY);
+    std::vector<size_t> copied, files, links;
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      while (!open_folders.empty() && !CyberManifest::inside(open_folders.back().path, entries[ind].path)) {
+        closing.push_back(std::move(open_folders.back()));
+        open_folders.pop_back();
+      }
+      if (entries[ind].isDirectory()) {
+        auto count = copied.size();
+        backup_entry(ind, copied);
+        if (copied.size() != count) {
+          open_folders.push_back(entries[ind]);
+        }
+      } else if (!entries[ind].link.empty()) {
+        links.push_back(ind);
+      } else {
+        files.push_back(ind);
+      }
+    }
+
+    std::vector<size_t> batch;
+    auto submit_batch = [&] {
+      pool.submit([&, batch](size_t worker) {
+        std::vector<CyberCopy::Job> jobs;
+        jobs.reserve(batch.size());
+        fs::path parent;
+        for (const auto& ind : batch) {
+          auto target_path = destination_norm / DIR_NAME / entries[ind].path;
+          if (target_path.parent_path() != parent) {
+            parent = target_path.parent_path();
+            std::error_code code;
+            fs::create_directories(parent, code);
+          }
+          jobs.push_back({source_norm / entries[ind].path, std::move(target_path), entries[ind].size, entries[ind].mode});
+        }
+
+        uint64_t bytes = 0;
+        for (const auto& job : jobs) {
+          bytes += job.size;
+        }
+        // The batch holds one slot while the ring reads, but pays only for the files it copied. The others are
+        // admitted on their own below and pay there.
+        auto slot = scheduler.admit(0, bytes, true);
+        auto started = CyberStats::now();
+        bool ringed = copier.copyFiles(jobs);
+        auto shared = (CyberStats::now() - started) / batch.size();
+        slot = {};
+        if (ringed) {
+          uint64_t ring_files = 0, ring_bytes = 0;
+          for (const auto& job : jobs) {
+            ring_files += job.result == 0 ? 1 : 0;
+            ring_bytes += job.result == 0 ? job.size : 0;
+          }
+          scheduler.charge(ring_files, ring_bytes);
+        }
+        for (size_t pos = 0; pos < batch.size(); ++pos) {
+          backup_entry(batch[pos], pool_copied[worker], ringed && jobs[pos].result == 0, shared);
+        }
+      });
+      batch.clear();
+    };
+
+    for (const auto& ind : files) {
+      if (snapshot && changed[ind] == 0) {
+        pool.submit([&, ind](size_t worker) { link_entry(ind, pool_copied[worker]); });
+        continue;
+      }
+      if (batched && copier.canBatch() && changed[ind] != 0 && entries[ind].isFile() && entries[ind].size <= CyberCopy::RING_MAX) {
+        batch.push_back(ind);
+        if (batch.size() == CyberCopy::RING_BATCH) {
+          submit_batch();
+        }
+        continue;
+      }
+      pool.submit([&, ind](size_t worker) { backup_entry(ind, pool_copied[worker]); });
+    }
+    if (!batch.empty()) {
+      submit_batch();
+    }
+    pool.wait();
+    mergeResults(copied, pool_copied);
+
+    // An entry is kept when it is stored by this backup or, unless it is a snapshot, by the one it builds on.
+    std::vector<char> done(entries.size(), 0);
+    for (const auto& ind : copied) {
+      done[ind] = 1;
+    }
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      done[ind] |= changed[ind] == 0 && !snapshot ? 2 : 0;
+    }
+    // A delta needs the backup holding its basis, which the manifest lists among its origins so restore checks for it.
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      const auto& name = bases[ind].origin;
+      if (done[ind] == 1 && entries[ind].storage == CyberEntry::Storage::DELTA &&
+          std::find(basis_origins.begin(), basis_origins.end(), name) == basis_origins.end()) {
+        basis_origins.push_back(name);
+      }
+    }
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      if (groups[ind] != nullptr && entries[ind].link.empty()) {
+        auto& leader = *groups[ind];
+        leader.stored = done[ind] != 0;
+        leader.tree = done[ind] == 1 && entries[ind].storage == CyberEntry::Storage::PLAIN;
+      }
+    }
+
+    // Further hardlinks go last, once the first path of their inode is stored. Only a plain copy made by this
+    // backup is linked in its tree as well, every other leader is found through the manifest on restore.
+    for (const auto& ind : links) {
+      auto started = CyberStats::now();
+      const auto& record = entries[ind];
+      const auto& leader = *groups[ind];
+      auto target_path = destination_norm / DIR_NAME / record.path;
+
+      bool copied_link = executeCopy(
+          [&](const fs::path& from, const fs::path& to) {
+            if (!leader.stored) {
+              throw fs::filesystem_error("link", from, source_norm / leader.path,
+                                         std::make_error_code(std::errc::no_such_file_or_directory));
+            }
+            if (leader.tree) {
+              fs::create_directories(to.parent_path());
+              fs::create_hard_link(destination_norm / DIR_NAME / leader.path, to);
+            }
+          },
+          success, errors, source_norm / record.path, target_path, destination / timestamp, true, source_norm / record.path,
+          target_path);
+      if (copied_link) {
+        done[ind] = 1;
+        ++linked;
+      }
+      stats.record(record, false, CyberStats::now() - started);
+    }
+    copy_timer.stop();
+    close_folders();
+
+    // Entries which failed to back up are left out, so the next incremental picks them up again.
+    auto summary_timer = stats.time(CyberStats::Phase::SUMMARY);
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      if (done[ind] != 0) {
+        auto index = manifest.add(entries[ind], entries[ind].link.empty() ? 0 : groups[ind]->record);
+        recorded = index + 1;
+        if (groups[ind] != nullptr && entries[ind].link.empty()) {
+          groups[ind]->record = static_cast<uint32_t>(index) + 1;
+        }
+      }
+    }
+  }
+  scanner.join();
+  raiseFailure();
+  if (scan_error) {
+    processFSError(*scan_error, nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+  }
+  stats.finishProgress();
+
+  if (getParam(params, Parameter::PACK)) {
+    try {
+      packer.finish();
+    } catch (const fs::filesystem_error& error) {
+      processFSError(error, nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
     }
   }
 
-  std::vector<size_t> err_stat;
-  for (size_t ind = 0; ind < success.size(); ++ind) {
-    if (!fs::is_symlink(success[ind].first)) {
-      auto result = setStat(success[ind].first, success[ind].second, destination / timestamp);
-      if (!result.empty()) {
-        success[ind].second = result;
-        err_stat.push_back(ind);
+  closing.insert(closing.end(), std::make_move_iterator(open_folders.rbegin()), std::make_move_iterator(open_folders.rend()));
+  open_folders.clear();
+  close_folders();
+
+  auto summary_timer = stats.time(CyberStats::Phase::SUMMARY);
+  for (; manifest_pos < base_manifest.size(); ++manifest_pos) {
+    note_deleted(base_manifest.name(manifest_pos));
+  }
+  auto kept = snapshot ? std::vector<std::string>{timestamp} : origins;
+  for (const auto& name : basis_origins) {
+    if (std::find(kept.begin(), kept.end(), name) == kept.end()) {
+      kept.push_back(name);
+    }
+  }
+  if (!manifest.finish(kept)) {
+    abort(static_cast<int>(std::errc::io_error), "Cannot create manifest file. Try to recreate backup.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS));
+  }
+  summary_timer.stop();
+
+  if (type != "full" && !compared) {
+    auto deletion_timer = stats.time(CyberStats::Phase::DELETION);
+    CyberScan::walk(base.path / DIR_NAME, [&](CyberEntry&& record) {
+      CyberEntry target_record;
+      if (!CyberScan::stat(source_norm / record.path, target_record)) {
+        note_deleted(record.path);
       }
+    });
+  }
+
+  sum_file.close();
+  std::error_code sum_code;
+  if (!sum_file) {
+    sum_code = std::make_error_code(std::errc::io_error);
+  } else {
+    fs::rename(sum_temp, sum_path, sum_code);
+  }
+  if (sum_code) {
+    abort(static_cast<int>(std::errc::no_such_file_or_directory), "Cannot create summary file. Try to recreate backup.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS));
+  }
+  catalogBackup({timestamp, type, base.timestamp, CyberCatalog::COMPLETE, recorded, stats.getCounters().bytes.load(),
+                 (fs::path(timestamp) / MAN_NAME).string()});
+  writeReport("backup", type, errors.size());
+
+  if (getParam(params, Parameter::SHOW_ERROR_STAT)) {
+    printInfo(errors, "ERROR INFORMATION", "Everything is OK!");
+  }
+  if (getParam(params, Parameter::SHOW_BACKUP_STAT)) {
+    printInfo(success, "BACK UP INFORMATION", "No one entry has been backed up!");
+    std::cout << "\nCopied files (" << copier.describe() << ")" << std::endl;
+    if (getParam(params, Parameter::DEDUPLICATE)) {
+      std::cout << "Deduplicated files (" << chunks.describe() << ")" << std::endl;
+    }
+    if (getParam(params, Parameter::COMPRESS)) {
+      std::cout << "Compressed files (" << compressor.describe() << ")" << std::endl;
+    }
+    if (getParam(params, Parameter::PACK)) {
+      std::cout << "Packed files (" << packer.describe() << ")" << std::endl;
+    }
+    if (deltas) {
+      std::cout << "Delta files (" << delta.describe() << ")" << std::endl;
     }
+    if (getParam(params, Parameter::HASH)) {
+      std::cout << "Hashed files (" << CyberHash::backend() << ", hashed: " << hashed.load() << ")" << std::endl;
+    }
+    std::cout << "Linked files (groups: " << link_groups << ", links: " << linked << ")" << std::endl;
+    if (replayed) {
+      std::cout << "Journaled files (changes: " << journal.size() << ")" << std::endl;
+    }
+    if (snapshot) {
+      std::cout << "Shared files (hardlinks: " << hardlinked.load() << ")" << std::endl;
+    }
+    std::cout << "Scheduler (" << scheduler.describe() << ")" << std::endl;
+    std::cout << "Phases (" << stats.describe() << ")" << std::endl;
   }
 
-  std::vector<std::pair<fs::path, fs::path>> success_new;
-  size_t pos = 0;
-  for (const auto& ind : err_stat) {
-    while (pos < success.size() && pos < ind) {
-      success_new.push_back(success[pos++]);
+  if (!getParam(params, Parameter::SILENT)) {
+    std::cout << "\n--> Backup operation completed!" << std::endl;
+  }
+}
+
+void CyberBackup::synthesize() const noexcept {
+  if (!fs::is_directory(destination)) {
+    abort(static_cast<int>(std::errc::no_such_file_or_directory),
+          "Destination folder (" + destination.string() + ") does not exist. Please check destination path.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_BASE));
+  }
+
+  // The last backup sees the source as it was most recently, whichever backups it builds on.
+  auto last = findLast(false);
+  auto timestamp = getTime();
+  if (fs::is_directory(destination / timestamp)) {
+    abort(static_cast<int>(std::errc::directory_not_empty), "Backup " + timestamp + " already exists.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_BASE));
+  }
+  try {
+    fs::create_directories(destination / timestamp / DIR_NAME);
+  } catch (const fs::filesystem_error& error) {
+    processFSError(error, nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+  }
+
+  auto last_norm = fs::canonical(fs::absolute(last.path));
+  auto destination_norm = fs::canonical(fs::absolute(destination)) / timestamp;
+
+  std::ifstream last_sum(last_norm / SUM_NAME);
+  std::string last_type, base_timestamp;
+  last_sum >> last_type >> base_timestamp;
+
+  // A chained manifest lists every entry together with the backup holding it. Older backups are laid over their full
+  // backup instead, without the paths their summary lists as deleted.
+  std::vector<fs::path> layers{last_norm};
+  CyberManifest last_manifest;
+  bool chained = last_manifest.open(last_norm / MAN_NAME) && last_manifest.originCount() != 0;
+  if (chained) {
+    for (size_t ind = 1; ind < last_manifest.originCount(); ++ind) {
+      layers.push_back(last_norm.parent_path() / last_manifest.origin(ind));
     }
-    errors.push_back(success[pos++]);
+  } else if (last.type == "chain" || last.type == "snapshot") {
+    abort(static_cast<int>(std::errc::invalid_argument),
+          "Manifest of the chain backup " + last.timestamp + " is missing or corrupted. Nothing to synthesize from.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+  } else if (base_timestamp != last.timestamp) {
+    layers.push_back(last_norm.parent_path() / base_timestamp);
+  }
+  for (const auto& layer : layers) {
+    if (!fs::is_directory(layer / DIR_NAME)) {
+      abort(static_cast<int>(std::errc::no_such_file_or_directory),
+            "Backup entity (" + layer.string() + ") of the chain does not exist. Nothing to synthesize from.",
+            nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+    }
+  }
+  auto deleted = readDeleted(last_sum, base_timestamp);
+  last_sum.close();
+
+  if (!getParam(params, Parameter::SILENT)) {
+    std::cout << "Synthesizing a full backup of " << last.timestamp << " in " << destination << "..." << std::endl;
+  }
+
+  if (getParam(params, Parameter::PROCESS)) {
+    std::cout << std::endl << std::string(MAX_STR, '-') << "PROCESS" << std::string(MAX_STR, '-') << std::endl;
   }
-  success_new.insert(success_new.end(), success.begin() + static_cast<int>(pos), success.end());
-  success = success_new;
 
-  std::ofstream sum_file(destination_norm / SUM_NAME, std::ios::out);
+  auto scan_timer = stats.time(CyberStats::Phase::SCAN);
+  std::vector<CyberEntry> merged;
+  if (!chained) {
+    merged = mergeBackup(layers, last_manifest, deleted);
+  }
+  size_t count = chained ? last_manifest.size() : merged.size();
+  auto entry_at = [&](size_t ind) { return chained ? last_manifest.entry(ind) : merged[ind]; };
+
+  uint64_t total_bytes = 0;
+  std::vector<char> packed_layers(layers.size(), 0);
+  for (size_t ind = 0; ind < count; ++ind) {
+    auto record = entry_at(ind);
+    if (record.isFile() && record.link.empty()) {
+      total_bytes += record.size;
+      packed_layers[record.origin] |= record.storage == CyberEntry::Storage::PACKED ? 1 : 0;
+    }
+  }
+  stats.setTotal(count, total_bytes);
+  scan_timer.stop();
+
+  auto sum_path = destination_norm / SUM_NAME;
+  auto sum_temp = sum_path;
+  sum_temp += ".tmp";
+  std::ofstream sum_file(sum_temp, std::ios::out);
   if (!sum_file.is_open()) {
-    sum_file.close();
     abort(static_cast<int>(std::errc::no_such_file_or_directory), "Cannot create summary file. Try to recreate backup.",
-          nullifyParams(params, Parameter::IGNORE_ERRORS));
+          nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+  }
+  sum_file << "full " << timestamp << "\n\n";
+
+  CyberManifest::Writer manifest;
+  if (!manifest.open(destination_norm / MAN_NAME)) {
+    abort(static_cast<int>(std::errc::io_error), "Cannot create manifest file. Try to recreate backup.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+  }
+
+  CyberLog success, errors;
+  CyberPool pool(jobs, &fatal);
+  std::vector<std::vector<size_t>> pool_copied(pool.size());
+
+  // Packed files go into segments of the new backup first, one task per old segment, so the batches below already
+  // know which of them made it.
+  auto copy_timer = stats.time(CyberStats::Phase::COPY);
+  std::vector<size_t> repacked;
+  if (std::find(packed_layers.begin(), packed_layers.end(), 1) != packed_layers.end()) {
+    try {
+      packer.prepare(destination_norm / PACK_NAME);
+    } catch (const fs::filesystem_error& error) {
+      processFSError(error, nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+    }
+    for (size_t origin = 0; origin < layers.size(); ++origin) {
+      if (packed_layers[origin] == 0) {
+        continue;
+      }
+      for (auto& segment : CyberPacker::listSegments(layers[origin] / PACK_NAME)) {
+        pool.submit([&, origin, segment = std::move(segment)](size_t worker) {
+          try {
+            packer.readSegment(segment, [&](const CyberPacker::Item& item, std::string_view name, const unsigned char* data) {
+              auto ind = chained ? last_manifest.find(name) : findEntry(merged, name);
+              if (ind == count) {
+                return;
+              }
+              auto record = entry_at(ind);
+              if (record.origin != origin || record.storage != CyberEntry::Storage::PACKED) {
+                return;
+              }
+              auto started = CyberStats::now();
+              bool copied = executeCopy([&] { packer.append(record, data, item.size); }, success, errors,
+                                        layers[origin] / PACK_NAME / name, destination_norm / PACK_NAME / name,
+                                        destination / timestamp, true);
+              if (copied) {
+                pool_copied[worker].push_back(ind);
+              }
+              stats.record(record, copied, CyberStats::now() - started);
+            });
+          } catch (const fs::filesystem_error& error) {
+            errors.add(segment.native(), reportFSError(error, destination / timestamp));
+          }
+        });
+      }
+    }
+    pool.wait();
+    raiseFailure();
+    mergeResults(repacked, pool_copied);
+    std::sort(repacked.begin(), repacked.end());
+    try {
+      packer.finish();
+    } catch (const fs::filesystem_error& error) {
+      processFSError(error, nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+    }
   }
-  sum_file << type << " " << full_backup_timestamp << "\n\n";
 
-  if (type == "incremental") {
-    for (const auto& entry : fs::recursive_directory_iterator(full_backup_norm / DIR_NAME)) {
-      auto relative_path =
-          entry.path().string().substr((full_backup_norm / DIR_NAME).string().size() + 1, entry.path().string().size());
-      auto target_path = source_norm / relative_path;
+  std::vector<CyberEntry> entries;
+  std::atomic<size_t> hardlinked = 0;
+  auto synthesize_entry = [&](size_t ind, std::vector<size_t>& entry_copied) {
+    auto started = CyberStats::now();
+    const auto& record = entries[ind];
+    auto entry = layers[record.origin] / DIR_NAME / record.path;
+    auto target_path = destination_norm / DIR_NAME / record.path;
+
+    bool copied = false;
+    if (record.isDirectory()) {
+      copied = executeCopy(
+          [&record](const fs::path& to) {
+            fs::create_directories(to);
+            CyberFile::setOwner(to, record);
+          },
+          success, errors, entry, target_path, destination / timestamp, true, target_path);
+    } else if (record.isFile() && record.storage == CyberEntry::Storage::DELTA) {
+      // A delta is rebuilt into a plain file, a full backup must not depend on the one holding its basis.
+      copied = executeCopy(
+          [this, &record, &last_norm](const fs::path& from, const fs::path& to) {
+            auto basis = last_norm.parent_path() / CyberDelta::basisOf(from) / DIR_NAME / record.path;
+            delta.decodeFile(from, basis, to, &record);
+          },
+          success, errors, entry, target_path, destination / timestamp, true, entry, target_path);
+      if (copied) {
+        entries[ind].storage = CyberEntry::Storage::PLAIN;
+      }
+    } else if (record.isFile()) {
+      // Whatever a backup stores is never written again, so sharing the inode is as good as a copy of it. Chunk
+      // recipes stay valid as well, the chunks they name are shared by every backup of the destination anyway.
+      copied = executeCopy(
+          [this, &record, &hardlinked](const fs::path& from, const fs::path& to) {
+            std::error_code code;
+            if (shared) {
+              fs::create_hard_link(from, to, code);
+              if (!code) {
+                ++hardlinked;
+                return;
+              }
+            }
+            copier.copyFile(from, to, &record);
+          },
+          success, errors, entry, target_path, destination / timestamp, true, entry, target_path);
+    } else {
+      copied = executeCopy(
+          [&record](const fs::path& from, const fs::path& to) {
+            fs::copy(from, to, fs::copy_options::copy_symlinks);
+            if (!record.isSymlink()) {
+              CyberFile::setStat(to, record);
+            }
+          },
+          success, errors, entry, target_path, destination / timestamp, true, entry, target_path);
+    }
+
+    if (copied) {
+      entry_copied.push_back(ind);
+    }
+    stats.record(record, copied, CyberStats::now() - started);
+  };
+
+  // Entries which fail are left out of the new manifest, dropped keeps their old indices to renumber the links after them.
+  std::vector<size_t> folders, dropped;
+  auto renumber = [&dropped](size_t ind) {
+    return ind - static_cast<size_t>(std::lower_bound(dropped.begin(), dropped.end(), ind) - dropped.begin());
+  };
+  auto leader_of = [&](size_t ind, const CyberEntry& record) {
+    return chained ? static_cast<size_t>(last_manifest.record(ind).link) - 1 : findEntry(merged, record.link);
+  };
+
+  size_t linked = 0, recorded = 0;
+  for (size_t start = 0; start < count; start += BATCH) {
+    entries.clear();
+    for (size_t ind = start; ind < std::min(count, start + BATCH); ++ind) {
+      entries.push_back(entry_at(ind));
+    }
+
+    // Directories are created up front on this thread, so every file task finds its parent in place.
+    std::vector<size_t> copied, links;
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      const auto& record = entries[ind];
+      if (record.isDirectory()) {
+        synthesize_entry(ind, copied);
+      } else if (!record.link.empty()) {
+        links.push_back(ind);
+      } else if (!record.isFile() || record.storage != CyberEntry::Storage::PACKED) {
+        pool.submit([&, ind](size_t worker) { synthesize_entry(ind, pool_copied[worker]); });
+      } else if (std::binary_search(repacked.begin(), repacked.end(), start + ind)) {
+        copied.push_back(ind);
+      } else {
+        auto error = fs::filesystem_error("unpack", layers[record.origin] / PACK_NAME, record.path,
+                                          std::make_error_code(std::errc::no_such_file_or_directory));
+        errors.add(record.path, reportFSError(error, destination / timestamp));
+      }
+    }
+    for (const auto& ind : copied) {
+      if (entries[ind].isDirectory()) {
+        folders.push_back(start + ind);
+      }
+    }
+    pool.wait();
+    raiseFailure();
+    mergeResults(copied, pool_copied);
+
+    std::vector<char> done(entries.size(), 0);
+    for (const auto& ind : copied) {
+      done[ind] = 1;
+    }
+
+    // Further hardlinks follow their first path, in the tree as well when that one is a plain file there.
+    for (const auto& ind : links) {
+      auto started = CyberStats::now();
+      const auto& record = entries[ind];
+      auto leader = leader_of(start + ind, record);
+      auto target_path = destination_norm / DIR_NAME / record.path;
 
-      if (!fs::is_symlink(target_path) && !fs::exists(target_path)) {
-        success.emplace_back(target_path, "DELETE");
-        sum_file << entry.path() << '\n';
+      bool copied_link = executeCopy(
+          [&](const fs::path& to) {
+            if (leader >= count || std::binary_search(dropped.begin(), dropped.end(), leader) ||
+                (leader >= start && done[leader - start] == 0)) {
+              throw fs::filesystem_error("link", destination_norm / DIR_NAME / record.link, to,
+                                         std::make_error_code(std::errc::no_such_file_or_directory));
+            }
+            if (entry_at(leader).storage == CyberEntry::Storage::PLAIN) {
+              fs::create_hard_link(destination_norm / DIR_NAME / record.link, to);
+            }
+          },
+          success, errors, layers[record.origin] / DIR_NAME / record.path, target_path, destination / timestamp, true,
+          target_path);
+      if (copied_link) {
+        done[ind] = 1;
+        ++linked;
+      }
+      stats.record(record, false, CyberStats::now() - started);
+    }
+
+    // Everything lives in the new backup now, which is the only origin of its manifest.
+    auto summary_timer = stats.time(CyberStats::Phase::SUMMARY);
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      if (done[ind] == 0) {
+        dropped.push_back(start + ind);
+        continue;
       }
+      auto link = entries[ind].link.empty() ? 0 : static_cast<uint32_t>(renumber(leader_of(start + ind, entries[ind]))) + 1;
+      entries[ind].origin = 0;
+      recorded = manifest.add(entries[ind], link) + 1;
     }
   }
+  copy_timer.stop();
+  stats.finishProgress();
 
+  // Directory modes and times go last and bottom-up, once nothing is created inside them any more.
+  auto metadata_timer = stats.time(CyberStats::Phase::METADATA);
+  for (const auto& ind : std::ranges::reverse_view(folders)) {
+    auto record = entry_at(ind);
+    try {
+      CyberFile::setStat(destination_norm / DIR_NAME / record.path, record, false);
+    } catch (const fs::filesystem_error& error) {
+      errors.add((layers[record.origin] / DIR_NAME / record.path).native(),
+                 processFSError(error, params, destination / timestamp));
+    }
+  }
+  metadata_timer.stop();
+
+  auto summary_timer = stats.time(CyberStats::Phase::SUMMARY);
+  if (!manifest.finish({timestamp})) {
+    abort(static_cast<int>(std::errc::io_error), "Cannot create manifest file. Try to recreate backup.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+  }
   sum_file.close();
+  std::error_code sum_code;
+  if (!sum_file) {
+    sum_code = std::make_error_code(std::errc::io_error);
+  } else {
+    fs::rename(sum_temp, sum_path, sum_code);
+  }
+  if (sum_code) {
+    abort(static_cast<int>(std::errc::no_such_file_or_directory), "Cannot create summary file. Try to recreate backup.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS), destination / timestamp);
+  }
+  catalogBackup({timestamp, "full", timestamp, CyberCatalog::COMPLETE, recorded, stats.getCounters().bytes.load(),
+                 (fs::path(timestamp) / MAN_NAME).string()});
+  summary_timer.stop();
+  writeReport("backup", type, errors.size());
 
   if (getParam(params, Parameter::SHOW_ERROR_STAT)) {
     printInfo(errors, "ERROR INFORMATION", "Everything is OK!");
   }
   if (getParam(params, Parameter::SHOW_BACKUP_STAT)) {
-    printInfo(success, "BACK UP INFORMATION", "No one entry has been backed up!");
+    printInfo(success, "SYNTHESIS INFORMATION", "No one entry has been synthesized!");
+    std::cout << "\nShared files (hardlinks: " << hardlinked.load() << ")" << std::endl;
+    std::cout << "Copied files (" << copier.describe() << ")" << std::endl;
+    std::cout << "Packed files (" << packer.describe() << ")" << std::endl;
+    std::cout << "Linked files (links: " << linked << ")" << std::endl;
+    std::cout << "Phases (" << stats.describe() << ")" << std::endl;
   }
 
   if (!getParam(params, Parameter::SILENT)) {
-    std::cout << "\n--> Backup operation completed!" << std::endl;
+    std::cout << "\n--> Synthesis operation completed!" << std::endl;
+  }
+}
+
+void CyberBackup::watch() const noexcept {
+  if (!fs::is_directory(source)) {
+    abort(static_cast<int>(std::errc::no_such_file_or_directory),
+          "Source entity (" + source.string() + ") does not exist. Please check source path.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_BASE));
+  }
+  if (!fs::is_directory(destination)) {
+    if (!getParam(params, Parameter::CREATE_DESTINATION)) {
+      abort(static_cast<int>(std::errc::no_such_file_or_directory),
+            "Destination folder (" + destination.string() + ") does not exist. Please check path or add 'create' operand.",
+            nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_BASE));
+    }
+    try {
+      fs::create_directories(destination);
+    } catch (const fs::filesystem_error& error) {
+      processFSError(error, nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_BASE));
+    }
+  }
+
+  auto source_norm = fs::canonical(fs::absolute(source));
+  auto destination_norm = fs::canonical(fs::absolute(destination));
+  auto journal_path = destination_norm / JOURNAL_NAME;
+
+  // One watch per destination, the lock goes away with the process however it ends.
+  auto lock_path = journal_path;
+  lock_path += ".lock";
+  int lock = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (lock == -1 || flock(lock, LOCK_EX | LOCK_NB) != 0) {
+    abort(static_cast<int>(std::errc::device_or_resource_busy),
+          "Destination folder (" + destination.string() + ") is watched already. Stop the other watch first.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_BASE));
+  }
+
+  CyberJournal journal(source_norm);
+  CyberWatch watcher(journal);
+  try {
+    watcher.start();
+  } catch (const fs::filesystem_error& error) {
+    processFSError(error, nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_BASE));
+  }
+
+  std::signal(SIGINT, stopWatch);
+  std::signal(SIGTERM, stopWatch);
+  if (!getParam(params, Parameter::SILENT)) {
+    std::cout << "Watching " << source << " for " << destination << " ("
+              << (watcher.getBackend() == CyberWatch::Backend::FANOTIFY ? "fanotify" : "inotify") << ")..." << std::endl;
+  }
+
+  // Changes from before the start of the last full backup are of no use any more: every later backup builds on it
+  // or on something newer.
+  auto last_full = [&] {
+    CyberCatalog::Record record;
+    bool found = openCatalog(destination_norm).findLast(
+        [&](const CyberCatalog::Record& item) {
+          std::error_code code;
+          return item.status == CyberCatalog::COMPLETE && item.type == "full" &&
+                 fs::exists(destination_norm / item.id / SUM_NAME, code);
+        },
+        record);
+    return found ? parseTime(record.id) : int64_t{0};
+  };
+
+  // Whatever happened before synced has been read once poll returns, the journal is saved with that promise.
+  int64_t pruned = 0;
+  bool saved = true;
+  while (watch_stop == 0) {
+    auto synced = CyberJournal::now();
+    try {
+      watcher.poll(CyberJournal::FLUSH_MS);
+    } catch (const fs::filesystem_error& error) {
+      if (error.code().value() == ENOSPC || error.code().value() == ENOMEM) {
+        abort(error.code().value(),
+              "Cannot watch every folder of " + source.string() + ". Raise fs.inotify.max_user_watches or run as root.",
+              nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_BASE));
+      }
+      processFSError(error, nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_BASE));
+    }
+    journal.setSynced(synced);
+    if (synced - pruned > PRUNE_MS * 1'000'000) {
+      journal.prune(last_full());
+      pruned = synced;
+    }
+
+    bool done = journal.save(journal_path);
+    if (!done && saved && !getParam(params, Parameter::SILENT)) {
+      std::lock_guard lock_output(output_mutex);
+      std::cerr << "Cannot write journal file (" << journal_path.string() << "). Check the path and permissions." << std::endl;
+    }
+    saved = done;
+  }
+
+  if (!getParam(params, Parameter::SILENT)) {
+    std::cout << "\nWatched changes (" << watcher.describe() << ", journaled: " << journal.size() << ")" << std::endl;
+    std::cout << "\n--> Watch stopped!" << std::endl;
   }
 }
 
@@ -11,29 +11,41 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <charconv>
 #include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#include "../include/CyberManifest.hpp"
 
 namespace nt {
 
 const char* CyberBase::DIR_NAME = "data";
 const char* CyberBase::SUM_NAME = "type.nt";
-const std::regex CyberBase::timestamp_pattern(R"(\d{4}-\d{2}-\d{2}_\d{2}-\d{2}-\d{2})");
+const char* CyberBase::MAN_NAME = "manifest.nt";
+const char* CyberBase::CHUNK_NAME = "chunks";
+const char* CyberBase::PACK_NAME = "packs";
+const char* CyberBase::JOURNAL_NAME = "journal.nt";
+const char* CyberBase::CATALOG_NAME = "catalog.nt";
+std::mutex CyberBase::output_mutex;
 
-void CyberBase::printInfo(const std::vector<std::pair<fs::path, fs::path>>& info, const std::string& title,
-                          const std::string& empty) {
+void CyberBase::printInfo(const CyberLog& info, const std::string& title, const std::string& empty) {
   auto format = std::string(MAX_STR - (title.size() - 7) / 2, '-');
   std::cout << std::endl << format << title << format << std::endl;
 
   if (!info.empty()) {
-    for (const auto& [lhs, rhs] : info) {
-      std::cout << preparePathOutput(lhs) << "  -->  " << preparePathOutput(rhs) << std::endl;
-    }
+    info.replay([](std::string_view lhs, std::string_view rhs) {
+      std::cout << preparePathOutput(lhs) << "  -->  " << preparePathOutput(rhs) << '\n';
+    });
+    std::cout.flush();
   } else {
     std::cout << empty << std::endl;
   }
 }
 
 void CyberBase::abort(int code, const std::string& msg, int params, const std::string& base) {
+  std::lock_guard lock(output_mutex);
   if (!getParam(params, Parameter::SILENT)) {
     std::cerr << msg << std::endl;
   }
@@ -66,40 +78,34 @@ std::string CyberBase::preparePathOutput(const fs::path& path) {
   return path_formatted;
 }
 
-std::string CyberBase::setStat(const fs::path& src, const fs::path& dst, const std::string& base) const {
-  std::string success;
-
-  fs::filesystem_error error("WTF", src, dst, std::error_code(0, std::generic_category()));
-
-  struct stat src_stat{};
-  if (stat(src.c_str(), &src_stat) == 0) {
-    if (chown(dst.c_str(), src_stat.st_uid, src_stat.st_gid) != 0) {
-      success += processErrnoError(error, params, base);
-      success += "  ";
-    }
-
-    if (chmod(dst.c_str(), src_stat.st_mode) != 0) {
-      success += processErrnoError(error, params, base);
-      success += "  ";
-    }
-
-    struct timespec times[2];
-    times[0].tv_sec = src_stat.st_atime;
-    times[0].tv_nsec = src_stat.st_atim.tv_nsec;
-
-    times[1].tv_sec = src_stat.st_mtime;
-    times[1].tv_nsec = src_stat.st_mtim.tv_nsec;
+std::string CyberBase::processFSError(const fs::filesystem_error& error, int params, const std::string& base) {
+  auto what = describeFSError(error);
+  abort(error.code().value(), what, params, base);
+  return what;
+}
 
-    if (utimensat(AT_FDCWD, dst.c_str(), times, 0) == -1) {
-      success += processErrnoError(error, params, base);
-      success += "  ";
-    }
+std::string CyberBase::reportFSError(const fs::filesystem_error& error, const std::string& base) const {
+  auto what = describeFSError(error);
+  // Ignored errors are only printed, abort returns for them.
+  if (getParam(params, Parameter::IGNORE_ERRORS)) {
+    abort(error.code().value(), what, params, base);
+    return what;
+  }
+  std::lock_guard lock(failure_mutex);
+  if (!fatal.load()) {
+    failure = {error.code().value(), what, base};
+    fatal = true;
   }
+  return what;
+}
 
-  return success;
+void CyberBase::raiseFailure() const {
+  if (fatal.load()) {
+    abort(failure.code, failure.what, params, failure.base);
+  }
 }
 
-std::string CyberBase::processFSError(const fs::filesystem_error& error, int params, const std::string& base) {
+std::string CyberBase::describeFSError(const fs::filesystem_error& error) {
   const auto& val = error.code().value();
   const auto& path1 = error.path1().string();
   const auto& path2 = error.path2().string();
@@ -113,7 +119,8 @@ std::string CyberBase::processFSError(const fs::filesystem_error& error, int par
       what = "Cannot find entry '" + path1 + "' or '" + path2 + "'. Try to check the path.";
       break;
     case static_cast<int>(std::errc::file_exists):
-      what = "Entry '" + path2 + "' already exists.";
+      // Opening the target itself reports it as the only path.
+      what = "Entry '" + (path2.empty() ? path1 : path2) + "' already exists.";
       break;
     case static_cast<int>(std::errc::not_a_directory):
       what = "Entry '" + path1 + "' is not a directory. Check if you selected correct entry or check the path.";
@@ -158,8 +165,6 @@ std::string CyberBase::processFSError(const fs::filesystem_error& error, int par
       what = error.code().message();
       break;
   }
-  abort(val, what, params, base);
-
   return what;
 }
 
@@ -216,4 +221,252 @@ bool CyberBase::getParam(int value, Parameter param) {
   return (value & static_cast<int>(param)) != 0;
 }
 
+size_t CyberBase::parseJobs(const std::string& value) {
+  size_t result = 0;
+  auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+  if (ec != std::errc() || ptr != value.data() + value.size() || result == 0) {
+    abort(static_cast<int>(std::errc::invalid_argument), "Wrong number of jobs '" + value + "'. Expected a positive integer.");
+  }
+  return result;
+}
+
+uint64_t CyberBase::parseRate(const std::string& value) {
+  uint64_t result = 0;
+  auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+  int shift = 0;
+  if (ptr != value.data() + value.size() && ptr + 1 == value.data() + value.size()) {
+    shift = *ptr == 'K' ? 10 : *ptr == 'M' ? 20 : *ptr == 'G' ? 30 : -1;
+    ++ptr;
+  }
+  if (ec != std::errc() || ptr != value.data() + value.size() || shift < 0 || result == 0 || result > (UINT64_MAX >> shift)) {
+    abort(static_cast<int>(std::errc::invalid_argument),
+          "Wrong rate '" + value + "'. Expected a positive integer, optionally followed by K, M or G.");
+  }
+  return result << shift;
+}
+
+CyberCopy::Mode CyberBase::parseCopyMode(const std::string& value) {
+  CyberCopy::Mode mode = CyberCopy::Mode::AUTO;
+  if (!CyberCopy::parseMode(value, mode)) {
+    abort(static_cast<int>(std::errc::invalid_argument),
+          "Wrong copy mode '" + value + "'. Did you mean 'auto', 'reflink', 'kernel' or 'buffer'?");
+  }
+  return mode;
+}
+
+bool CyberBase::parseSchedule(const std::string& operand) {
+  if (operand.starts_with("rate=")) {
+    scheduler.setBytesRate(parseRate(operand.substr(5)));
+  } else if (operand.starts_with("files=")) {
+    scheduler.setFilesRate(parseRate(operand.substr(6)));
+  } else if (operand.starts_with("io=")) {
+    auto priority = CyberScheduler::Priority::DEFAULT;
+    int level = 0;
+    if (!CyberScheduler::parsePriority(operand.substr(3), priority, level)) {
+      abort(static_cast<int>(std::errc::invalid_argument),
+            "Wrong I/O priority '" + operand.substr(3) + "'. Did you mean 'idle', 'best-effort' or 'best-effort:<0-7>'?");
+    }
+    scheduler.setPriority(priority, level);
+  } else if (operand.starts_with("latency=")) {
+    // Milliseconds, or microseconds with a 'us' suffix for fast devices.
+    auto value = operand.substr(8);
+    uint64_t scale = 1'000'000;
+    if (value.ends_with("us")) {
+      value.resize(value.size() - 2);
+      scale = 1'000;
+    }
+    uint64_t result = 0;
+    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (ec != std::errc() || ptr != value.data() + value.size() || result == 0 || result > UINT64_MAX / scale) {
+      abort(static_cast<int>(std::errc::invalid_argument),
+            "Wrong latency '" + operand.substr(8) + "'. Expected a positive number of milliseconds, or of microseconds "
+            "followed by 'us'.");
+    }
+    scheduler.setLatency(result * scale);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void CyberBase::startScheduler(const fs::path& path) {
+  try {
+    scheduler.start(path, jobs);
+  } catch (const fs::filesystem_error& error) {
+    if (!getParam(params, Parameter::SILENT)) {
+      std::lock_guard lock(output_mutex);
+      std::cerr << "Cannot set the I/O priority (" << error.code().message() << "), running with the default one."
+                << std::endl;
+    }
+  }
+}
+
+size_t CyberBase::findEntry(const std::vector<CyberEntry>& entries, std::string_view path) {
+  auto it = std::lower_bound(entries.begin(), entries.end(), path, [](const CyberEntry& lhs, std::string_view rhs) {
+    return CyberManifest::compare(lhs.path, rhs) < 0;
+  });
+  return it != entries.end() && it->path == path ? static_cast<size_t>(it - entries.begin()) : entries.size();
+}
+
+bool CyberBase::isTimestamp(std::string_view value) noexcept {
+  static constexpr std::string_view FORMAT = "dddd-dd-dd_dd-dd-dd";
+  if (value.size() != FORMAT.size()) {
+    return false;
+  }
+  for (size_t ind = 0; ind < value.size(); ++ind) {
+    if (FORMAT[ind] == 'd' ? value[ind] < '0' || value[ind] > '9' : value[ind] != FORMAT[ind]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<CyberCatalog::Record> CyberBase::scanBackups(const fs::path& folder) {
+  // Destinations from before the catalog only have their summaries, a backup is complete once it has one.
+  std::vector<CyberCatalog::Record> records;
+  std::error_code code;
+  for (const auto& entry : fs::directory_iterator(folder, code)) {
+    auto name = entry.path().filename().string();
+    if (!isTimestamp(name) || !entry.is_directory(code)) {
+      continue;
+    }
+    std::ifstream sum_file(entry.path() / SUM_NAME);
+    CyberCatalog::Record record;
+    record.id = name;
+    if (!(sum_file >> record.type >> record.base) || !isTimestamp(record.base)) {
+      continue;
+    }
+    record.status = CyberCatalog::COMPLETE;
+    if (fs::exists(entry.path() / MAN_NAME, code)) {
+      record.manifest = (fs::path(name) / MAN_NAME).string();
+    }
+    records.push_back(std::move(record));
+  }
+  std::sort(records.begin(), records.end(), [](const auto& lhs, const auto& rhs) { return lhs.id < rhs.id; });
+  return records;
+}
+
+CyberCatalog CyberBase::openCatalog(const fs::path& folder) {
+  CyberCatalog catalog(folder / CATALOG_NAME);
+  if (catalog.exists()) {
+    return catalog;
+  }
+  auto records = scanBackups(folder);
+  try {
+    catalog.create(records);
+  } catch (const fs::filesystem_error&) {
+    catalog.setRecords(std::move(records));
+  }
+  return catalog;
+}
+
+bool CyberBase::addToCatalog(const fs::path& folder, const CyberCatalog::Record& record) {
+  CyberCatalog catalog(folder / CATALOG_NAME);
+  try {
+    // A catalog built now finds the backup complete already and takes its record as it is.
+    if (!catalog.exists()) {
+      auto records = scanBackups(folder);
+      std::erase_if(records, [&record](const auto& item) { return item.id == record.id; });
+      records.insert(std::upper_bound(records.begin(), records.end(), record,
+                                      [](const auto& lhs, const auto& rhs) { return lhs.id < rhs.id; }),
+                     record);
+      if (catalog.create(records)) {
+        return true;
+      }
+    }
+    catalog.append(record);
+  } catch (const fs::filesystem_error&) {
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::string> CyberBase::readDeleted(std::istream& sum_file, const std::string& base_timestamp) {
+  // Summaries written before deletions became relative hold absolute paths into the data folder of the full backup.
+  std::vector<std::string> deleted;
+  auto marker = "/" + base_timestamp + "/" + DIR_NAME + "/";
+  for (std::string path; sum_file >> std::quoted(path);) {
+    if (auto pos = path.find(marker); !path.empty() && path.front() == '/' && pos != std::string::npos) {
+      path.erase(0, pos + marker.size());
+    }
+    deleted.push_back(std::move(path));
+  }
+  std::sort(deleted.begin(), deleted.end(),
+            [](const auto& lhs, const auto& rhs) { return CyberManifest::compare(lhs, rhs) < 0; });
+  return deleted;
+}
+
+std::vector<CyberEntry> CyberBase::mergeBackup(const std::vector<fs::path>& layers, const CyberManifest& manifest,
+                                               const std::vector<std::string>& deleted) {
+  // The full backup is read from its manifest when there is one. Both sides are sorted, so one merge decides
+  // for every path which layer supplies it.
+  auto merged = CyberScan::scan(layers[0] / DIR_NAME);
+  applyStorage(merged, manifest, 0);
+  if (layers.size() < 2) {
+    return merged;
+  }
+
+  CyberManifest full_manifest;
+  std::vector<CyberEntry> full_entries;
+  if (full_manifest.open(layers[1] / MAN_NAME)) {
+    full_entries.reserve(full_manifest.size());
+    for (size_t ind = 0; ind < full_manifest.size(); ++ind) {
+      full_entries.push_back(full_manifest.entry(ind));
+    }
+  } else {
+    full_entries = CyberScan::scan(layers[1] / DIR_NAME);
+  }
+  for (auto& entry : full_entries) {
+    entry.origin = 1;
+  }
+  return mergeLayers(merged, full_entries, deleted);
+}
+
+std::vector<CyberEntry> CyberBase::mergeLayers(std::vector<CyberEntry>& upper, std::vector<CyberEntry>& lower,
+                                               const std::vector<std::string>& deleted) {
+  std::vector<CyberEntry> result;
+  result.reserve(upper.size() + lower.size());
+
+  size_t up = 0, del = 0;
+  for (auto& entry : lower) {
+    while (up < upper.size() && CyberManifest::compare(upper[up].path, entry.path) < 0) {
+      result.push_back(std::move(upper[up++]));
+    }
+    while (del < deleted.size() && CyberManifest::compare(deleted[del], entry.path) < 0) {
+      ++del;
+    }
+
+    if (up < upper.size() && upper[up].path == entry.path) {
+      result.push_back(std::move(upper[up++]));
+    } else if (del == deleted.size() || deleted[del] != entry.path) {
+      result.push_back(std::move(entry));
+    }
+  }
+  std::move(upper.begin() + static_cast<ptrdiff_t>(up), upper.end(), std::back_inserter(result));
+
+  return result;
+}
+
+void CyberBase::applyStorage(std::vector<CyberEntry>& entries, const CyberManifest& manifest, uint16_t origin) {
+  size_t pos = 0;
+  for (auto& entry : entries) {
+    if (entry.origin != origin || !entry.isFile()) {
+      continue;
+    }
+    while (pos < manifest.size() && CyberManifest::compare(manifest.name(pos), entry.path) < 0) {
+      ++pos;
+    }
+    if (pos < manifest.size() && manifest.name(pos) == entry.path) {
+      entry.storage = static_cast<CyberEntry::Storage>(manifest.record(pos).storage);
+    }
+  }
+}
+
+void CyberBase::writeReport(const std::string& tool, const std::string& kind, size_t errors) const {
+  if (!report.empty() && !stats.writeReport(report, tool, kind, errors) && !getParam(params, Parameter::SILENT)) {
+    std::lock_guard lock(output_mutex);
+    std::cerr << "Cannot write report file (" << report.string() << "). Check the path and permissions." << std::endl;
+  }
+}
+
 }  // namespace nt
@@ -0,0 +1,133 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 7:30 PM
+ *  File    : CyberCatalog.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberCatalog.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iomanip>
+#include <ranges>
+#include <sstream>
+
+#include "../include/CyberFile.hpp"
+
+namespace nt {
+
+CyberCatalog::CyberCatalog(fs::path path) : path(std::move(path)) {}
+
+bool CyberCatalog::exists() const {
+  struct stat info{};
+  return ::stat(path.c_str(), &info) == 0;
+}
+
+void CyberCatalog::setRecords(std::vector<Record> value) {
+  records = std::move(value);
+}
+
+const fs::path& CyberCatalog::getPath() const noexcept {
+  return path;
+}
+
+std::string CyberCatalog::format(const Record& record) {
+  std::ostringstream line;
+  line << record.id << ' ' << record.type << ' ' << record.base << ' ' << record.status << ' ' << record.entries << ' '
+       << record.bytes << ' ' << std::quoted(record.manifest) << '\n';
+  return line.str();
+}
+
+bool CyberCatalog::parse(std::string_view line, Record& record) {
+  std::istringstream input{std::string(line)};
+  return static_cast<bool>(input >> record.id >> record.type >> record.base >> record.status >> record.entries >>
+                           record.bytes >> std::quoted(record.manifest));
+}
+
+bool CyberCatalog::create(const std::vector<Record>& value) const {
+  std::string temp = path.string() + ".XXXXXX";
+  int fd = mkstemp(temp.data());
+  if (fd == -1) {
+    throw fs::filesystem_error("catalog", path, std::error_code(errno, std::generic_category()));
+  }
+
+  // The catalog is linked into place, which fails rather than replaces one some other tool has created meanwhile.
+  CyberFile file(fd, temp);
+  bool created = false;
+  try {
+    std::string text;
+    for (const auto& record : value) {
+      text += format(record);
+    }
+    file.write(text.data(), text.size());
+    fchmod(file.get(), 0644);
+    file.close();
+    created = ::link(temp.c_str(), path.c_str()) == 0;
+    if (!created && errno != EEXIST) {
+      throw fs::filesystem_error("catalog", path, std::error_code(errno, std::generic_category()));
+    }
+  } catch (const fs::filesystem_error&) {
+    ::unlink(temp.c_str());
+    throw;
+  }
+
+  ::unlink(temp.c_str());
+  return created;
+}
+
+void CyberCatalog::append(const Record& record) const {
+  auto file = CyberFile::open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+  auto line = format(record);
+  file.write(line.data(), line.size());
+}
+
+bool CyberCatalog::findLast(const Match& match, Record& found) const {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    for (const auto& record : std::ranges::reverse_view(records)) {
+      if (match(record)) {
+        found = record;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Chunks are read from the end. Every line of a chunk but its first is complete, which waits for the one before.
+  CyberFile file(fd, path);
+  auto end = static_cast<uint64_t>(file.size());
+  std::string text, rest;
+  Record record;
+  while (end > 0) {
+    auto start = end > CHUNK ? end - CHUNK : 0;
+    text.resize(end - start);
+    text.resize(file.readAt(text.data(), text.size(), static_cast<off_t>(start)));
+    text += rest;
+
+    size_t stop = text.size();
+    while (stop != 0) {
+      auto newline = text.rfind('\n', stop - 1);
+      if (newline == std::string::npos) {
+        break;
+      }
+      if (parse(std::string_view(text).substr(newline + 1, stop - newline - 1), record) && match(record)) {
+        found = std::move(record);
+        return true;
+      }
+      stop = newline;
+    }
+    rest = text.substr(0, stop);
+    end = start;
+  }
+
+  if (parse(rest, record) && match(record)) {
+    found = std::move(record);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace nt
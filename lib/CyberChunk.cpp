@@ -0,0 +1,235 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 11:20 AM
+ *  File    : CyberChunk.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberChunk.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "../include/CyberFile.hpp"
+
+namespace nt {
+
+namespace {
+
+// Normalized chunking: a stricter mask below the average size and a looser one above it pulls
+// chunk sizes towards AVG_CHUNK. The gear hash shifts left, so its top bits cover the last 64 bytes.
+constexpr uint64_t MASK_SMALL = ~0ULL << (64 - 18);
+constexpr uint64_t MASK_LARGE = ~0ULL << (64 - 14);
+
+constexpr auto GEAR = [] {
+  std::array<uint64_t, 256> result{};
+  uint64_t state = 0x4E54436875636B73ULL;
+  for (auto& value : result) {
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t mixed = state;
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+    value = mixed ^ (mixed >> 31);
+  }
+  return result;
+}();
+
+}  // namespace
+
+CyberChunkStore::CyberChunkStore(fs::path root) : root(std::move(root)) {}
+
+void CyberChunkStore::setRoot(const fs::path& value) {
+  root = value;
+}
+
+const fs::path& CyberChunkStore::getRoot() const noexcept {
+  return root;
+}
+
+const CyberChunkStore::Counters& CyberChunkStore::getCounters() const noexcept {
+  return counters;
+}
+
+std::string CyberChunkStore::describe() const {
+  return "chunks: " + std::to_string(counters.chunks.load()) + ", duplicates: " + std::to_string(counters.duplicates.load()) +
+         ", bytes: " + std::to_string(counters.bytes.load()) + ", stored: " + std::to_string(counters.stored_bytes.load());
+}
+
+void CyberChunkStore::prepare() const {
+  static constexpr char DIGITS[] = "0123456789abcdef";
+  for (char high : std::string_view(DIGITS, 16)) {
+    for (char low : std::string_view(DIGITS, 16)) {
+      fs::create_directories(root / std::string{high, low});
+    }
+  }
+}
+
+fs::path CyberChunkStore::chunkPath(const CyberHash::Digest& digest) const {
+  auto name = digest.hex();
+  return root / name.substr(0, 2) / name;
+}
+
+size_t CyberChunkStore::findCut(const unsigned char* data, size_t size) noexcept {
+  if (size <= MIN_CHUNK) {
+    return size;
+  }
+
+  size_t limit = std::min(size, MAX_CHUNK);
+  size_t normal = std::min(limit, AVG_CHUNK);
+  uint64_t hash = 0;
+  size_t ind = MIN_CHUNK;
+  for (; ind < normal; ++ind) {
+    hash = (hash << 1) + GEAR[data[ind]];
+    if ((hash & MASK_SMALL) == 0) {
+      return ind + 1;
+    }
+  }
+  for (; ind < limit; ++ind) {
+    hash = (hash << 1) + GEAR[data[ind]];
+    if ((hash & MASK_LARGE) == 0) {
+      return ind + 1;
+    }
+  }
+  return limit;
+}
+
+void CyberChunkStore::storeChunk(const CyberHash::Digest& digest, const unsigned char* data, size_t size) const {
+  ++counters.chunks;
+  counters.bytes += size;
+
+  auto path = chunkPath(digest);
+  if (access(path.c_str(), F_OK) == 0) {
+    ++counters.duplicates;
+    return;
+  }
+
+  // Chunks are written aside and renamed into place, so a reader never sees a partial one.
+  std::string temp = path.string() + ".XXXXXX";
+  int fd = mkstemp(temp.data());
+  if (fd == -1) {
+    throw fs::filesystem_error("chunk", path, std::error_code(errno, std::generic_category()));
+  }
+
+  CyberFile file(fd, temp);
+  try {
+    file.write(data, size);
+    file.close();
+    fs::rename(temp, path);
+  } catch (const fs::filesystem_error&) {
+    ::unlink(temp.c_str());
+    throw;
+  }
+  counters.stored_bytes += size;
+}
+
+void CyberChunkStore::storeFile(const fs::path& src, const fs::path& recipe, const CyberEntry* stat) const {
+  auto input = CyberFile::open(src, O_RDONLY | O_NOFOLLOW);
+  posix_fadvise(input.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+  auto output = CyberFile::open(recipe, O_WRONLY | O_CREAT | O_EXCL);
+
+  try {
+    thread_local std::vector<unsigned char> buffer(4 * MAX_CHUNK);
+    std::vector<RecipeChunk> chunks;
+    uint64_t total = 0;
+    size_t length = 0;
+    bool eof = false;
+
+    while (!eof || length != 0) {
+      if (!eof) {
+        size_t wanted = buffer.size() - length;
+        size_t got = input.read(buffer.data() + length, wanted);
+        eof = got < wanted;
+        length += got;
+      }
+
+      // Without more input to come the tail is cut as well, otherwise only full windows are.
+      size_t pos = 0;
+      while (length - pos >= MAX_CHUNK || (eof && pos < length)) {
+        size_t cut = findCut(buffer.data() + pos, length - pos);
+        auto digest = CyberHash::hash(buffer.data() + pos, cut);
+        storeChunk(digest, buffer.data() + pos, cut);
+        chunks.push_back({digest.low, digest.high, static_cast<uint32_t>(cut), 0});
+        total += cut;
+        pos += cut;
+      }
+
+      std::memmove(buffer.data(), buffer.data() + pos, length - pos);
+      length -= pos;
+    }
+
+    RecipeHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.size = total;
+    header.count = chunks.size();
+    output.write(&header, sizeof(header));
+    output.write(chunks.data(), chunks.size() * sizeof(RecipeChunk));
+  } catch (const fs::filesystem_error&) {
+    output.close();
+    ::unlink(recipe.c_str());
+    throw;
+  }
+
+  if (stat != nullptr) {
+    output.setStat(*stat);
+  }
+}
+
+void CyberChunkStore::restoreFile(const fs::path& recipe, const fs::path& dst, const CyberEntry* stat) const {
+  auto output = CyberFile::open(dst, O_WRONLY | O_CREAT | O_EXCL);
+  try {
+    uint64_t total = 0;
+    readFile(recipe, [&output, &total](const unsigned char* data, size_t size) {
+      output.writeSparse(data, size, static_cast<off_t>(total));
+      total += size;
+    });
+    output.resize(static_cast<off_t>(total));
+  } catch (const fs::filesystem_error&) {
+    output.close();
+    ::unlink(dst.c_str());
+    throw;
+  }
+
+  if (stat != nullptr) {
+    output.setStat(*stat);
+  }
+}
+
+uint64_t CyberChunkStore::readFile(const fs::path& recipe, const CyberFile::Sink& sink) const {
+  auto input = CyberFile::open(recipe, O_RDONLY);
+
+  RecipeHeader header{};
+  if (input.read(&header, sizeof(header)) != sizeof(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != VERSION ||
+      header.count != (static_cast<uint64_t>(input.size()) - sizeof(header)) / sizeof(RecipeChunk)) {
+    input.fail(EINVAL, "recipe");
+  }
+
+  std::vector<RecipeChunk> chunks(header.count);
+  if (input.read(chunks.data(), chunks.size() * sizeof(RecipeChunk)) != chunks.size() * sizeof(RecipeChunk)) {
+    input.fail(EINVAL, "recipe");
+  }
+
+  thread_local std::vector<unsigned char> buffer(MAX_CHUNK + 1);
+  uint64_t total = 0;
+  for (const auto& chunk : chunks) {
+    CyberHash::Digest digest{chunk.low, chunk.high};
+    auto file = CyberFile::open(chunkPath(digest), O_RDONLY);
+    if (chunk.size > MAX_CHUNK || file.read(buffer.data(), buffer.size()) != chunk.size ||
+        CyberHash::hash(buffer.data(), chunk.size) != digest) {
+      file.fail(EIO, "chunk");
+    }
+    sink(buffer.data(), chunk.size);
+    total += chunk.size;
+  }
+  if (total != header.size) {
+    input.fail(EINVAL, "recipe");
+  }
+  return total;
+}
+
+}  // namespace nt
@@ -0,0 +1,427 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 3:10 PM
+ *  File    : CyberCompress.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberCompress.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "../include/CyberFile.hpp"
+#include "../include/CyberPool.hpp"
+
+namespace nt {
+
+namespace {
+
+// Sequence format: token (literal length << 4 | match length - MIN_MATCH), extra literal length bytes, literals,
+// 16-bit little-endian offset, extra match length bytes. Lengths of 15 continue in 255-valued bytes.
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MATCH_LIMIT = 12;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_LOG = 14;
+constexpr uint32_t EMPTY = UINT32_MAX;
+
+uint32_t load32(const unsigned char* data) noexcept {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t hash32(uint32_t value) noexcept {
+  return (value * 2654435761U) >> (32 - HASH_LOG);
+}
+
+size_t matchLength(const unsigned char* lhs, const unsigned char* rhs, size_t limit) noexcept {
+  size_t length = 0;
+  if constexpr (std::endian::native == std::endian::little) {
+    while (length + sizeof(uint64_t) <= limit) {
+      uint64_t left, right;
+      std::memcpy(&left, lhs + length, sizeof(left));
+      std::memcpy(&right, rhs + length, sizeof(right));
+      if (left != right) {
+        return length + std::countr_zero(left ^ right) / 8;
+      }
+      length += sizeof(uint64_t);
+    }
+  }
+  while (length < limit && lhs[length] == rhs[length]) {
+    ++length;
+  }
+  return length;
+}
+
+bool putLength(unsigned char*& out, const unsigned char* end, size_t length) noexcept {
+  for (; length >= 255; length -= 255) {
+    if (out == end) {
+      return false;
+    }
+    *out++ = 255;
+  }
+  if (out == end) {
+    return false;
+  }
+  *out++ = static_cast<unsigned char>(length);
+  return true;
+}
+
+// A zero match size writes the closing sequence, which carries literals only.
+bool putSequence(unsigned char*& out, const unsigned char* end, const unsigned char* literals, size_t literal_size,
+                 size_t offset, size_t match_size) noexcept {
+  if (out == end) {
+    return false;
+  }
+  auto* token = out++;
+  *token = static_cast<unsigned char>(std::min<size_t>(literal_size, 15) << 4);
+  if (literal_size >= 15 && !putLength(out, end, literal_size - 15)) {
+    return false;
+  }
+  if (static_cast<size_t>(end - out) < literal_size) {
+    return false;
+  }
+  std::memcpy(out, literals, literal_size);
+  out += literal_size;
+
+  if (match_size == 0) {
+    return true;
+  }
+  if (end - out < 2) {
+    return false;
+  }
+  *out++ = static_cast<unsigned char>(offset & 0xFF);
+  *out++ = static_cast<unsigned char>(offset >> 8);
+  size_t extra = match_size - MIN_MATCH;
+  *token |= static_cast<unsigned char>(std::min<size_t>(extra, 15));
+  return extra < 15 || putLength(out, end, extra - 15);
+}
+
+bool getLength(const unsigned char*& in, const unsigned char* end, size_t& length) noexcept {
+  unsigned char byte;
+  do {
+    if (in == end) {
+      return false;
+    }
+    byte = *in++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}  // namespace
+
+const CyberCompressor::Counters& CyberCompressor::getCounters() const noexcept {
+  return counters;
+}
+
+std::string CyberCompressor::describe() const {
+  return "compressed: " + std::to_string(counters.compressed.load()) + ", skipped: " + std::to_string(counters.skipped.load()) +
+         ", decompressed: " + std::to_string(counters.decompressed.load()) + ", bytes: " + std::to_string(counters.bytes.load()) +
+         ", stored: " + std::to_string(counters.stored_bytes.load());
+}
+
+size_t CyberCompressor::bound(size_t size) noexcept {
+  return size + size / 255 + 16;
+}
+
+double CyberCompressor::entropy(const unsigned char* data, size_t size) noexcept {
+  if (size == 0) {
+    return 0;
+  }
+
+  std::array<size_t, 256> counts{};
+  for (size_t ind = 0; ind < size; ++ind) {
+    ++counts[data[ind]];
+  }
+
+  double result = 0;
+  for (auto count : counts) {
+    if (count != 0) {
+      double part = static_cast<double>(count) / static_cast<double>(size);
+      result -= part * std::log2(part);
+    }
+  }
+  return result;
+}
+
+size_t CyberCompressor::compressBlock(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity) noexcept {
+  unsigned char* out = dst;
+  const unsigned char* end = dst + capacity;
+  size_t anchor = 0;
+
+  // Greedy single-probe matcher. Misses speed up the further they get from the last match, so incompressible
+  // stretches are skipped quickly. No match starts in the last MATCH_LIMIT bytes or reaches the last LAST_LITERALS.
+  if (size > MATCH_LIMIT) {
+    std::array<uint32_t, 1 << HASH_LOG> table;
+    table.fill(EMPTY);
+
+    size_t limit = size - MATCH_LIMIT;
+    size_t match_end = size - LAST_LITERALS;
+    size_t pos = 0;
+    while (pos < limit) {
+      uint32_t sequence = load32(src + pos);
+      auto& slot = table[hash32(sequence)];
+      size_t candidate = slot;
+      slot = static_cast<uint32_t>(pos);
+      if (candidate == EMPTY || pos - candidate > MAX_OFFSET || load32(src + candidate) != sequence) {
+        pos += 1 + ((pos - anchor) >> 6);
+        continue;
+      }
+
+      while (pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1]) {
+        --pos;
+        --candidate;
+      }
+      size_t length = MIN_MATCH + matchLength(src + pos + MIN_MATCH, src + candidate + MIN_MATCH, match_end - pos - MIN_MATCH);
+      if (!putSequence(out, end, src + anchor, pos - anchor, pos - candidate, length)) {
+        return 0;
+      }
+      pos += length;
+      anchor = pos;
+    }
+  }
+
+  if (!putSequence(out, end, src + anchor, size - anchor, 0, 0)) {
+    return 0;
+  }
+  return out - dst;
+}
+
+bool CyberCompressor::decompressBlock(const unsigned char* src, size_t size, unsigned char* dst, size_t raw_size) noexcept {
+  const unsigned char* in = src;
+  const unsigned char* in_end = src + size;
+  unsigned char* out = dst;
+  unsigned char* out_end = dst + raw_size;
+
+  while (in != in_end) {
+    unsigned char token = *in++;
+    size_t literal_size = token >> 4;
+    if (literal_size == 15 && !getLength(in, in_end, literal_size)) {
+      return false;
+    }
+    if (static_cast<size_t>(in_end - in) < literal_size || static_cast<size_t>(out_end - out) < literal_size) {
+      return false;
+    }
+    std::memcpy(out, in, literal_size);
+    in += literal_size;
+    out += literal_size;
+    if (in == in_end) {
+      break;
+    }
+
+    if (in_end - in < 2) {
+      return false;
+    }
+    size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+    in += 2;
+    size_t match_size = token & 15;
+    if (match_size == 15 && !getLength(in, in_end, match_size)) {
+      return false;
+    }
+    match_size += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(out - dst) || match_size > static_cast<size_t>(out_end - out)) {
+      return false;
+    }
+
+    const unsigned char* match = out - offset;
+    if (offset >= match_size) {
+      std::memcpy(out, match, match_size);
+    } else {
+      for (size_t ind = 0; ind < match_size; ++ind) {
+        out[ind] = match[ind];
+      }
+    }
+    out += match_size;
+  }
+
+  return out == out_end;
+}
+
+bool CyberCompressor::compressFile(const fs::path& src, const fs::path& dst, const CyberEntry* stat) const {
+  auto input = CyberFile::open(src, O_RDONLY | O_NOFOLLOW);
+  auto size = static_cast<uint64_t>(input.size());
+  if (size < MIN_SIZE) {
+    return false;
+  }
+
+  // Archives, media and encrypted data have near-random bytes, the head of the file is enough to tell.
+  thread_local std::vector<unsigned char> buffer(GROUP * (BLOCK + bound(BLOCK)));
+  auto sampled = input.readAt(buffer.data(), std::min<uint64_t>(size, SAMPLE_SIZE), 0);
+  if (entropy(buffer.data(), sampled) > MAX_ENTROPY) {
+    ++counters.skipped;
+    return false;
+  }
+
+  posix_fadvise(input.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+  auto output = CyberFile::open(dst, O_WRONLY | O_CREAT | O_EXCL);
+
+  uint64_t offset = sizeof(Header), total = 0;
+  std::vector<Block> index;
+  try {
+    Header header{};
+    output.write(&header, sizeof(header));
+
+    // Blocks are read and packed a group at a time by the whole pool, then appended in order by this thread.
+    auto* raw = buffer.data();
+    auto* packed = raw + GROUP * BLOCK;
+    std::array<uint32_t, GROUP> raw_sizes{}, stored_sizes{};
+    size_t count = (size + BLOCK - 1) / BLOCK;
+    bool last = false;
+    for (size_t first = 0; first < count && !last; first += GROUP) {
+      size_t blocks = std::min(GROUP, count - first);
+      CyberPool::split(blocks, [&](size_t ind) {
+        raw_sizes[ind] = input.readAt(raw + ind * BLOCK, BLOCK, static_cast<off_t>((first + ind) * BLOCK));
+        stored_sizes[ind] = raw_sizes[ind] == 0 ? 0
+                                                : compressBlock(raw + ind * BLOCK, raw_sizes[ind], packed + ind * bound(BLOCK),
+                                                                raw_sizes[ind] - 1);
+      });
+
+      // A short block ends the file, even when it has shrunk since it was opened.
+      for (size_t ind = 0; ind < blocks && !last; ++ind) {
+        last = raw_sizes[ind] < BLOCK;
+        if (raw_sizes[ind] == 0) {
+          break;
+        }
+        uint32_t stored = stored_sizes[ind] != 0 ? stored_sizes[ind] : raw_sizes[ind];
+        output.write(stored_sizes[ind] != 0 ? packed + ind * bound(BLOCK) : raw + ind * BLOCK, stored);
+        index.push_back({offset, stored, raw_sizes[ind]});
+        offset += stored;
+        total += raw_sizes[ind];
+      }
+    }
+    output.write(index.data(), index.size() * sizeof(Block));
+
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.block_size = BLOCK;
+    header.size = total;
+    header.count = index.size();
+    header.index_offset = offset;
+    output.writeAt(&header, sizeof(header), 0);
+  } catch (const fs::filesystem_error&) {
+    output.close();
+    ::unlink(dst.c_str());
+    throw;
+  }
+
+  ++counters.compressed;
+  counters.bytes += total;
+  counters.stored_bytes += offset + index.size() * sizeof(Block);
+  if (stat != nullptr) {
+    output.setStat(*stat);
+  }
+  return true;
+}
+
+std::vector<uint64_t> CyberCompressor::readIndex(const CyberFile& input, std::vector<Block>& index) {
+  auto file_size = static_cast<uint64_t>(input.size());
+
+  Header header{};
+  if (input.readAt(&header, sizeof(header), 0) != sizeof(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != VERSION || header.block_size != BLOCK || header.index_offset < sizeof(Header) ||
+      header.index_offset > file_size || (file_size - header.index_offset) % sizeof(Block) != 0 ||
+      header.count != (file_size - header.index_offset) / sizeof(Block)) {
+    input.fail(EINVAL, "compressed");
+  }
+
+  index.resize(header.count);
+  if (input.readAt(index.data(), index.size() * sizeof(Block), static_cast<off_t>(header.index_offset)) !=
+      index.size() * sizeof(Block)) {
+    input.fail(EINVAL, "compressed");
+  }
+
+  std::vector<uint64_t> positions(index.size());
+  uint64_t total = 0;
+  for (size_t ind = 0; ind < index.size(); ++ind) {
+    const auto& block = index[ind];
+    if (block.raw_size > BLOCK || block.stored_size > block.raw_size || block.offset < sizeof(Header) ||
+        block.offset + block.stored_size > header.index_offset) {
+      input.fail(EINVAL, "compressed");
+    }
+    positions[ind] = total;
+    total += block.raw_size;
+  }
+  if (total != header.size) {
+    input.fail(EINVAL, "compressed");
+  }
+  return positions;
+}
+
+void CyberCompressor::decompressFile(const fs::path& src, const fs::path& dst, const CyberEntry* stat) const {
+  auto input = CyberFile::open(src, O_RDONLY);
+  std::vector<Block> index;
+  auto positions = readIndex(input, index);
+  uint64_t total = index.empty() ? 0 : positions.back() + index.back().raw_size;
+
+  // Every block knows both of its offsets, so the pool unpacks and writes them in any order.
+  auto output = CyberFile::open(dst, O_WRONLY | O_CREAT | O_EXCL);
+  try {
+    CyberPool::split(index.size(), [&](size_t ind) {
+      thread_local std::vector<unsigned char> packed(BLOCK), raw(BLOCK);
+      const auto& block = index[ind];
+      if (input.readAt(packed.data(), block.stored_size, static_cast<off_t>(block.offset)) != block.stored_size) {
+        input.fail(EIO, "compressed");
+      }
+      if (block.stored_size == block.raw_size) {
+        output.writeSparse(packed.data(), block.raw_size, static_cast<off_t>(positions[ind]));
+      } else if (decompressBlock(packed.data(), block.stored_size, raw.data(), block.raw_size)) {
+        output.writeSparse(raw.data(), block.raw_size, static_cast<off_t>(positions[ind]));
+      } else {
+        input.fail(EIO, "compressed");
+      }
+    });
+    // Blocks of zeros were left as holes, the length comes from the header.
+    output.resize(static_cast<off_t>(total));
+  } catch (const fs::filesystem_error&) {
+    output.close();
+    ::unlink(dst.c_str());
+    throw;
+  }
+
+  ++counters.decompressed;
+  if (stat != nullptr) {
+    output.setStat(*stat);
+  }
+}
+
+uint64_t CyberCompressor::readFile(const fs::path& src, const CyberFile::Sink& sink) const {
+  auto input = CyberFile::open(src, O_RDONLY);
+  posix_fadvise(input.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+  std::vector<Block> index;
+  readIndex(input, index);
+
+  // Like compressFile, the pool unpacks a group of blocks at a time, which this thread then passes on in order.
+  thread_local std::vector<unsigned char> buffer(GROUP * 2 * BLOCK);
+  auto* raw = buffer.data();
+  auto* packed = raw + GROUP * BLOCK;
+  uint64_t total = 0;
+  for (size_t first = 0; first < index.size(); first += GROUP) {
+    size_t blocks = std::min(GROUP, index.size() - first);
+    CyberPool::split(blocks, [&](size_t ind) {
+      const auto& block = index[first + ind];
+      auto* stored = block.stored_size == block.raw_size ? raw + ind * BLOCK : packed + ind * BLOCK;
+      if (input.readAt(stored, block.stored_size, static_cast<off_t>(block.offset)) != block.stored_size) {
+        input.fail(EIO, "compressed");
+      }
+      if (stored != raw + ind * BLOCK && !decompressBlock(stored, block.stored_size, raw + ind * BLOCK, block.raw_size)) {
+        input.fail(EIO, "compressed");
+      }
+    });
+    for (size_t ind = 0; ind < blocks; ++ind) {
+      sink(raw + ind * BLOCK, index[first + ind].raw_size);
+      total += index[first + ind].raw_size;
+    }
+  }
+  return total;
+}
+
+}  // namespace nt
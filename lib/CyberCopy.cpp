@@ -0,0 +1,416 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 16 October 2026, 4:30 PM
+ *  File    : CyberCopy.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberCopy.hpp"
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <vector>
+
+#include "../include/CyberFile.hpp"
+#include "../include/CyberRing.hpp"
+
+namespace nt {
+
+namespace {
+
+constexpr size_t BUFFER_SIZE = 1 << 20;
+constexpr size_t KERNEL_CHUNK = 1 << 30;
+
+// Errors meaning "this mechanism does not work here", after which AUTO mode moves on to the next one.
+bool isUnsupported(int code) {
+  return code == EOPNOTSUPP || code == ENOTSUP || code == EXDEV || code == EINVAL || code == ENOSYS || code == ENOTTY;
+}
+
+// Every file of a ring batch is one linked chain: open both ends into registered slots, read, write, close both.
+// Registered slots are not descriptors of the process, so they take no O_CLOEXEC (the kernel rejects it).
+enum RingOp : uint64_t {
+  OPEN_SRC,
+  READ,
+  OPEN_DST,
+  WRITE,
+  CLOSE_SRC,
+  CLOSE_DST,
+  RING_OPS,
+};
+
+// The read asks for one byte past the scanned size, so a file which grew since the scan reads long and is copied the
+// usual way instead of being cut off. Buffers hold that extra byte.
+constexpr size_t RING_SLOT = CyberCopy::RING_MAX + 1;
+
+std::atomic<bool> ring_disabled = false;
+
+}  // namespace
+
+CyberCopy::CyberCopy(Mode mode) : mode(mode) {}
+
+void CyberCopy::setMode(Mode value) noexcept {
+  mode = value;
+}
+
+CyberCopy::Mode CyberCopy::getMode() const noexcept {
+  return mode;
+}
+
+bool CyberCopy::canBatch() const noexcept {
+  return mode == Mode::AUTO && !ring_disabled.load();
+}
+
+const CyberCopy::Counters& CyberCopy::getCounters() const noexcept {
+  return counters;
+}
+
+std::string CyberCopy::describe() const {
+  return "ring: " + std::to_string(counters.ring.load()) + ", reflink: " + std::to_string(counters.reflink.load()) +
+         ", kernel: " + std::to_string(counters.kernel.load()) + ", buffer: " + std::to_string(counters.buffer.load()) +
+         ", sparse: " + std::to_string(counters.sparse.load()) + ", bytes: " + std::to_string(counters.bytes.load()) +
+         ", holes: " + std::to_string(counters.holes.load());
+}
+
+bool CyberCopy::parseMode(const std::string& value, Mode& result) {
+  if (value == "auto") {
+    result = Mode::AUTO;
+  } else if (value == "reflink") {
+    result = Mode::REFLINK;
+  } else if (value == "kernel") {
+    result = Mode::KERNEL;
+  } else if (value == "buffer") {
+    result = Mode::BUFFER;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void CyberCopy::copyFile(const fs::path& src, const fs::path& dst, const CyberEntry* stat, const Pace& pace) const {
+  auto src_file = CyberFile::open(src, O_RDONLY | O_NOFOLLOW);
+
+  struct stat src_stat{};
+  if (fstat(src_file.get(), &src_stat) != 0) {
+    src_file.fail(errno, "stat");
+  }
+  if (!S_ISREG(src_stat.st_mode)) {
+    src_file.fail(EINVAL, "copy");
+  }
+
+  auto dst_file = CyberFile::open(dst, O_WRONLY | O_CREAT | O_EXCL, src_stat.st_mode & 07777);
+  auto discard = [&](int code) {
+    dst_file.close();
+    ::unlink(dst.c_str());
+    throw fs::filesystem_error("copy", src, dst, std::error_code(code, std::generic_category()));
+  };
+  // Metadata failures keep the copied data, the caller still reports the entry as failed.
+  auto finish = [&](std::atomic<size_t>& counter, uint64_t bytes) {
+    ++counter;
+    counters.bytes += bytes;
+    if (stat != nullptr) {
+      dst_file.setStat(*stat);
+    }
+  };
+
+  if (mode == Mode::AUTO || mode == Mode::REFLINK) {
+    if (copyReflink(src_file.get(), dst_file.get())) {
+      finish(counters.reflink, src_stat.st_size);
+      return;
+    }
+    if (mode == Mode::REFLINK || !isUnsupported(errno)) {
+      discard(errno);
+    }
+  }
+
+  uint64_t copied = 0;
+  // Fewer allocated blocks than bytes means holes. Filesystems without SEEK_DATA fall back to a full copy.
+  if (static_cast<uint64_t>(src_stat.st_blocks) * 512 < static_cast<uint64_t>(src_stat.st_size)) {
+    if (copySparse(src_file.get(), dst_file.get(), src_stat.st_size, mode != Mode::BUFFER, copied, pace)) {
+      counters.holes += src_stat.st_size - copied;
+      finish(counters.sparse, copied);
+      return;
+    }
+    // SEEK_DATA moved the source offset, the full copy below has to start over from zero.
+    if (!isUnsupported(errno) || lseek(src_file.get(), 0, SEEK_SET) != 0) {
+      discard(errno);
+    }
+    copied = 0;
+  }
+
+  if (mode == Mode::AUTO || mode == Mode::KERNEL) {
+    if (copyKernel(src_file.get(), dst_file.get(), copied, pace)) {
+      finish(counters.kernel, copied);
+      return;
+    }
+    if (mode == Mode::KERNEL || !isUnsupported(errno)) {
+      discard(errno);
+    }
+  }
+
+  // copy_file_range moved the file offsets along, so a partial kernel copy is finished from where it stopped.
+  if (!copyBuffer(src_file.get(), dst_file.get(), copied, pace)) {
+    discard(errno);
+  }
+  finish(counters.buffer, copied);
+}
+
+bool CyberCopy::copyFiles(std::vector<Job>& jobs) const {
+  if (mode != Mode::AUTO || ring_disabled.load()) {
+    return false;
+  }
+
+  // Each batch is submitted and reaped in full before the next one is prepared, so a queue holding one batch never
+  // runs out of entries.
+  thread_local CyberRing ring(RING_BATCH * RING_OPS, 2 * RING_BATCH);
+  if (!ring.isOpen() || ring.capacity() < RING_BATCH * RING_OPS) {
+    ring_disabled = true;
+    return false;
+  }
+
+  thread_local std::vector<unsigned char> buffer(RING_BATCH * RING_SLOT);
+  for (size_t first = 0; first < jobs.size(); first += RING_BATCH) {
+    size_t count = std::min(RING_BATCH, jobs.size() - first);
+
+    for (size_t ind = 0; ind < count; ++ind) {
+      const auto& job = jobs[first + ind];
+      auto* data = buffer.data() + ind * RING_SLOT;
+      auto src_slot = static_cast<uint32_t>(2 * ind);
+      auto dst_slot = src_slot + 1;
+
+      auto* sqe = ring.prepare();
+      sqe->opcode = IORING_OP_OPENAT;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = reinterpret_cast<uint64_t>(job.src.c_str());
+      sqe->open_flags = O_RDONLY | O_NOFOLLOW;
+      sqe->file_index = src_slot + 1;
+      sqe->flags = IOSQE_IO_LINK;
+      sqe->user_data = ind * RING_OPS + OPEN_SRC;
+
+      sqe = ring.prepare();
+      sqe->opcode = IORING_OP_READ;
+      sqe->fd = static_cast<int>(src_slot);
+      sqe->addr = reinterpret_cast<uint64_t>(data);
+      // Reading up to the end is short by design, a hard link keeps the chain going, the checks below catch the rest.
+      sqe->len = static_cast<uint32_t>(job.size + 1);
+      sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+      sqe->user_data = ind * RING_OPS + READ;
+
+      sqe = ring.prepare();
+      sqe->opcode = IORING_OP_OPENAT;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = reinterpret_cast<uint64_t>(job.dst.c_str());
+      sqe->open_flags = O_WRONLY | O_CREAT | O_EXCL;
+      sqe->len = job.mode & 07777;
+      sqe->file_index = dst_slot + 1;
+      sqe->flags = IOSQE_IO_LINK;
+      sqe->user_data = ind * RING_OPS + OPEN_DST;
+
+      sqe = ring.prepare();
+      sqe->opcode = IORING_OP_WRITE;
+      sqe->fd = static_cast<int>(dst_slot);
+      sqe->addr = reinterpret_cast<uint64_t>(data);
+      sqe->len = static_cast<uint32_t>(job.size);
+      sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK;
+      sqe->user_data = ind * RING_OPS + WRITE;
+
+      sqe = ring.prepare();
+      sqe->opcode = IORING_OP_CLOSE;
+      sqe->file_index = src_slot + 1;
+      sqe->flags = IOSQE_IO_LINK;
+      sqe->user_data = ind * RING_OPS + CLOSE_SRC;
+
+      sqe = ring.prepare();
+      sqe->opcode = IORING_OP_CLOSE;
+      sqe->file_index = dst_slot + 1;
+      sqe->user_data = ind * RING_OPS + CLOSE_DST;
+    }
+
+    // A failed or short request cancels the rest of its chain, but every request still posts a completion.
+    std::array<std::array<int, RING_OPS>, RING_BATCH> results{};
+    for (auto& result : results) {
+      result.fill(-ECANCELED);
+    }
+    size_t expected = count * RING_OPS, received = 0;
+    bool broken = false;
+    while (received < expected) {
+      int submitted = ring.submit(static_cast<unsigned>(expected - received));
+      if (submitted < 0 && !broken) {
+        // Requests the kernel took still complete and write into the buffer, so they are waited for. The others are
+        // taken back and count as cancelled, the checks below then clean up after both.
+        ring_disabled = true;
+        broken = true;
+        expected -= ring.discard();
+        continue;
+      }
+      if (submitted < 0) {
+        break;
+      }
+      received += ring.reap([&results](uint64_t data, int result) { results[data / RING_OPS][data % RING_OPS] = result; });
+    }
+
+    for (size_t ind = 0; ind < count; ++ind) {
+      auto& job = jobs[first + ind];
+      const auto& result = results[ind];
+      bool done = result[OPEN_SRC] == 0 && static_cast<uint64_t>(result[READ]) == job.size && result[OPEN_DST] == 0 &&
+                  static_cast<uint64_t>(result[WRITE]) == job.size && result[CLOSE_DST] >= 0;
+      if (done) {
+        job.result = 0;
+        ++counters.ring;
+        counters.bytes += job.size;
+        continue;
+      }
+
+      // Kernels without direct descriptors reject the file index, or older ones ignore it and return a descriptor of
+      // the process, which is closed here. Either way the plain path is used from now on.
+      if (result[OPEN_SRC] == -EINVAL || result[OPEN_SRC] == -EBADF) {
+        ring_disabled = true;
+      }
+      for (auto op : {OPEN_SRC, OPEN_DST}) {
+        if (result[op] > 0) {
+          ::close(result[op]);
+          ring_disabled = true;
+        }
+      }
+      job.result = EIO;
+      for (auto code : result) {
+        if (code < 0 && code != -ECANCELED) {
+          job.result = -code;
+          break;
+        }
+      }
+      if (result[OPEN_DST] >= 0) {
+        ::unlink(job.dst.c_str());
+      }
+    }
+    if (broken) {
+      for (size_t ind = first + count; ind < jobs.size(); ++ind) {
+        jobs[ind].result = ECANCELED;
+      }
+      return true;
+    }
+  }
+  return true;
+}
+
+bool CyberCopy::copyReflink(int src_fd, int dst_fd) {
+  return ioctl(dst_fd, FICLONE, src_fd) == 0;
+}
+
+bool CyberCopy::copyKernel(int src_fd, int dst_fd, uint64_t& copied, const Pace& pace) {
+  size_t chunk = pace ? PACE_CHUNK : KERNEL_CHUNK;
+  while (true) {
+    auto result = copy_file_range(src_fd, nullptr, dst_fd, nullptr, chunk, 0);
+    if (result == 0) {
+      return true;
+    }
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    copied += result;
+    if (pace) {
+      pace(result);
+    }
+  }
+}
+
+bool CyberCopy::copySparse(int src_fd, int dst_fd, uint64_t size, bool kernel, uint64_t& copied, const Pace& pace) {
+  thread_local std::vector<char> buffer(BUFFER_SIZE);
+  size_t chunk = pace ? PACE_CHUNK : KERNEL_CHUNK;
+
+  // Offsets are passed explicitly, so a fallback to a full copy still starts from the beginning of both files.
+  for (off_t offset = 0; static_cast<uint64_t>(offset) < size;) {
+    off_t data = lseek(src_fd, offset, SEEK_DATA);
+    if (data < 0) {
+      if (errno == ENXIO) {
+        break;
+      }
+      return false;
+    }
+    off_t hole = lseek(src_fd, data, SEEK_HOLE);
+    if (hole < 0) {
+      return false;
+    }
+    hole = std::min<off_t>(hole, static_cast<off_t>(size));
+
+    for (off_t pos = data; pos < hole;) {
+      ssize_t result = 0;
+      if (kernel) {
+        loff_t in = pos, out = pos;
+        result = copy_file_range(src_fd, &in, dst_fd, &out, std::min<size_t>(hole - pos, chunk), 0);
+        if (result < 0 && isUnsupported(errno)) {
+          kernel = false;
+          continue;
+        }
+      } else {
+        result = pread(src_fd, buffer.data(), std::min<size_t>(hole - pos, buffer.size()), pos);
+        for (ssize_t written = 0; result > 0 && written < result;) {
+          auto chunk = pwrite(dst_fd, buffer.data() + written, result - written, pos + written);
+          if (chunk < 0 && errno != EINTR) {
+            return false;
+          }
+          written += std::max<ssize_t>(chunk, 0);
+        }
+      }
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      if (result == 0) {
+        break;
+      }
+      pos += result;
+      copied += result;
+      if (pace) {
+        pace(result);
+      }
+    }
+    offset = hole;
+  }
+
+  return ftruncate(dst_fd, static_cast<off_t>(size)) == 0;
+}
+
+bool CyberCopy::copyBuffer(int src_fd, int dst_fd, uint64_t& copied, const Pace& pace) {
+  thread_local std::vector<char> buffer(BUFFER_SIZE);
+  posix_fadvise(src_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  while (true) {
+    auto result = read(src_fd, buffer.data(), buffer.size());
+    if (result == 0) {
+      return true;
+    }
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    for (ssize_t written = 0; written < result;) {
+      auto chunk = write(dst_fd, buffer.data() + written, result - written);
+      if (chunk < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      written += chunk;
+    }
+    copied += result;
+    if (pace) {
+      pace(result);
+    }
+  }
+}
+
+}  // namespace nt
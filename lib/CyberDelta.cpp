@@ -0,0 +1,363 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 6:10 PM
+ *  File    : CyberDelta.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberDelta.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include "../include/CyberFile.hpp"
+#include "../include/CyberHash.hpp"
+
+namespace nt {
+
+namespace {
+
+constexpr uint32_t EMPTY = UINT32_MAX;
+constexpr size_t WINDOW = 4 << 20;
+
+// The weak checksum is rsync's: a is the sum of the bytes, b the sum of the running values of a, 16 bits each.
+uint32_t combine(uint32_t a, uint32_t b) noexcept {
+  return (a & 0xFFFF) | (b << 16);
+}
+
+uint32_t slot(uint32_t weak, int bits) noexcept {
+  return (weak * 0x9E3779B1U) >> (32 - bits);
+}
+
+bool isUnsupported(int code) noexcept {
+  return code == EXDEV || code == EINVAL || code == ENOSYS || code == EOPNOTSUPP;
+}
+
+// Ranges go through copy_file_range, which may share the extents instead of copying them; a plain loop does the rest.
+void copyRange(const CyberFile& from, uint64_t offset, const CyberFile& to, uint64_t target, uint64_t length) {
+  thread_local std::vector<unsigned char> buffer(1 << 20);
+  bool kernel = true;
+  while (length != 0) {
+    ssize_t result = 0;
+    if (kernel) {
+      loff_t in = static_cast<loff_t>(offset), out = static_cast<loff_t>(target);
+      result = copy_file_range(from.get(), &in, to.get(), &out, length, 0);
+      if (result < 0 && isUnsupported(errno)) {
+        kernel = false;
+        continue;
+      }
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      if (result < 0) {
+        to.fail(errno, "delta");
+      }
+    } else {
+      auto wanted = std::min<uint64_t>(length, buffer.size());
+      result = static_cast<ssize_t>(from.readAt(buffer.data(), wanted, static_cast<off_t>(offset)));
+      to.writeAt(buffer.data(), result, static_cast<off_t>(target));
+    }
+    if (result == 0) {
+      from.fail(EIO, "delta");
+    }
+    offset += result;
+    target += result;
+    length -= result;
+  }
+}
+
+}  // namespace
+
+const CyberDelta::Counters& CyberDelta::getCounters() const noexcept {
+  return counters;
+}
+
+std::string CyberDelta::describe() const {
+  return "encoded: " + std::to_string(counters.encoded.load()) + ", skipped: " + std::to_string(counters.skipped.load()) +
+         ", decoded: " + std::to_string(counters.decoded.load()) + ", bytes: " + std::to_string(counters.bytes.load()) +
+         ", matched: " + std::to_string(counters.matched_bytes.load()) +
+         ", stored: " + std::to_string(counters.stored_bytes.load());
+}
+
+size_t CyberDelta::blockSize(uint64_t size) noexcept {
+  auto root = static_cast<uint64_t>(std::sqrt(static_cast<double>(size)));
+  return std::clamp<size_t>(std::bit_ceil(root), MIN_BLOCK, MAX_BLOCK);
+}
+
+uint32_t CyberDelta::checksum(const unsigned char* data, size_t size) noexcept {
+  uint32_t a = 0, b = 0;
+  for (size_t ind = 0; ind < size; ++ind) {
+    a += data[ind];
+    b += a;
+  }
+  return combine(a, b);
+}
+
+std::string CyberDelta::basisOf(const fs::path& path) {
+  auto input = CyberFile::open(path, O_RDONLY);
+  Header header{};
+  if (input.readAt(&header, sizeof(header), 0) != sizeof(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != VERSION || header.basis[NAME_SIZE - 1] != '\0') {
+    input.fail(EINVAL, "delta");
+  }
+  return header.basis;
+}
+
+bool CyberDelta::encodeFile(const fs::path& src, const fs::path& basis, const std::string& basis_name, const fs::path& dst,
+                            const CyberEntry* stat) const {
+  auto input = CyberFile::open(src, O_RDONLY | O_NOFOLLOW);
+  if (static_cast<uint64_t>(input.size()) < MIN_SIZE || basis_name.size() >= NAME_SIZE) {
+    return false;
+  }
+  auto reference = CyberFile::open(basis, O_RDONLY | O_NOFOLLOW);
+  auto basis_size = static_cast<uint64_t>(reference.size());
+  size_t block = blockSize(basis_size);
+  size_t count = basis_size / block;
+  if (count == 0 || count >= EMPTY) {
+    return false;
+  }
+
+  // Signature of every whole block of the basis, chained by the slot of its weak checksum.
+  thread_local std::vector<unsigned char> buffer;
+  buffer.resize(std::max(WINDOW, 4 * block));
+  std::vector<uint32_t> weak(count), next(count);
+  std::vector<CyberHash::Digest> strong(count);
+  int bits = std::bit_width(std::bit_ceil(2 * count)) - 1;
+  std::vector<uint32_t> table(size_t{1} << bits, EMPTY);
+  posix_fadvise(reference.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+  size_t per_read = buffer.size() / block;
+  for (size_t first = 0; first < count; first += per_read) {
+    size_t blocks = std::min(per_read, count - first);
+    if (reference.readAt(buffer.data(), blocks * block, static_cast<off_t>(first * block)) != blocks * block) {
+      reference.fail(EIO, "delta");
+    }
+    for (size_t ind = 0; ind < blocks; ++ind) {
+      const auto* data = buffer.data() + ind * block;
+      auto number = static_cast<uint32_t>(first + ind);
+      weak[number] = checksum(data, block);
+      strong[number] = CyberHash::hash(data, block);
+      auto& head = table[slot(weak[number], bits)];
+      next[number] = head;
+      head = number;
+    }
+  }
+  reference.close();
+
+  posix_fadvise(input.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+  auto output = CyberFile::open(dst, O_WRONLY | O_CREAT | O_EXCL);
+
+  std::vector<Op> ops;
+  uint64_t offset = sizeof(Header), total = 0, matched = 0;
+  try {
+    Header header{};
+    output.write(&header, sizeof(header));
+
+    auto emit = [&ops](bool literal, uint64_t from, uint64_t length) {
+      if (!ops.empty() && (ops.back().literal != 0) == literal && ops.back().offset + ops.back().length == from) {
+        ops.back().length += length;
+      } else {
+        ops.push_back({from, length, literal ? 1U : 0U, 0});
+      }
+    };
+
+    // The window [pos, pos + block) rolls over the buffer one byte at a time until it matches a block, bytes it
+    // leaves behind unmatched since lit are literals. Literals are written out whenever the buffer is refilled.
+    size_t length = 0, pos = 0, lit = 0;
+    uint32_t a = 0, b = 0;
+    bool eof = false, rolling = false;
+    auto flush = [&](size_t end) {
+      if (end > lit) {
+        output.write(buffer.data() + lit, end - lit);
+        emit(true, offset, end - lit);
+        offset += end - lit;
+      }
+      lit = end;
+    };
+
+    for (;;) {
+      if (length - pos < block && !eof) {
+        flush(pos);
+        std::memmove(buffer.data(), buffer.data() + pos, length - pos);
+        length -= pos;
+        lit = pos = 0;
+        size_t wanted = buffer.size() - length;
+        size_t got = input.read(buffer.data() + length, wanted);
+        eof = got < wanted;
+        length += got;
+        total += got;
+        continue;
+      }
+      if (length - pos < block) {
+        break;
+      }
+
+      const auto* window = buffer.data() + pos;
+      if (!rolling) {
+        a = b = 0;
+        for (size_t ind = 0; ind < block; ++ind) {
+          a += window[ind];
+          b += a;
+        }
+        rolling = true;
+      }
+
+      auto value = combine(a, b);
+      uint32_t found = EMPTY;
+      std::optional<CyberHash::Digest> digest;
+      for (auto number = table[slot(value, bits)]; number != EMPTY; number = next[number]) {
+        if (weak[number] != value) {
+          continue;
+        }
+        if (!digest) {
+          digest = CyberHash::hash(window, block);
+        }
+        if (strong[number] == *digest) {
+          found = number;
+          break;
+        }
+      }
+
+      if (found != EMPTY) {
+        flush(pos);
+        emit(false, static_cast<uint64_t>(found) * block, block);
+        matched += block;
+        pos += block;
+        lit = pos;
+        rolling = false;
+      } else if (pos + block < length) {
+        uint32_t out = window[0], in = window[block];
+        a += in - out;
+        b += a - static_cast<uint32_t>(block) * out;
+        ++pos;
+      } else {
+        ++pos;
+        rolling = false;
+      }
+    }
+    flush(length);
+
+    // Half the file found in the basis at least, or a restore would depend on it for too little.
+    if (matched * 2 < total) {
+      output.close();
+      ::unlink(dst.c_str());
+      ++counters.skipped;
+      return false;
+    }
+
+    output.write(ops.data(), ops.size() * sizeof(Op));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.block_size = static_cast<uint32_t>(block);
+    header.size = total;
+    header.basis_size = basis_size;
+    header.count = ops.size();
+    header.index_offset = offset;
+    std::memcpy(header.basis, basis_name.data(), basis_name.size());
+    output.writeAt(&header, sizeof(header), 0);
+  } catch (const fs::filesystem_error&) {
+    output.close();
+    ::unlink(dst.c_str());
+    throw;
+  }
+
+  ++counters.encoded;
+  counters.bytes += total;
+  counters.matched_bytes += matched;
+  counters.stored_bytes += offset + ops.size() * sizeof(Op);
+  if (stat != nullptr) {
+    output.setStat(*stat);
+  }
+  return true;
+}
+
+std::vector<CyberDelta::Op> CyberDelta::readOps(const CyberFile& input, const CyberFile& reference) {
+  auto file_size = static_cast<uint64_t>(input.size());
+
+  Header header{};
+  if (input.readAt(&header, sizeof(header), 0) != sizeof(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != VERSION || header.index_offset < sizeof(Header) || header.index_offset > file_size ||
+      (file_size - header.index_offset) % sizeof(Op) != 0 || header.count != (file_size - header.index_offset) / sizeof(Op)) {
+    input.fail(EINVAL, "delta");
+  }
+
+  std::vector<Op> ops(header.count);
+  if (input.readAt(ops.data(), ops.size() * sizeof(Op), static_cast<off_t>(header.index_offset)) != ops.size() * sizeof(Op)) {
+    input.fail(EINVAL, "delta");
+  }
+
+  // Backups are never written again, a basis of another size is not the one the delta was made against.
+  if (static_cast<uint64_t>(reference.size()) != header.basis_size) {
+    reference.fail(EINVAL, "delta basis");
+  }
+
+  uint64_t total = 0;
+  for (const auto& op : ops) {
+    bool valid = op.literal != 0 ? op.offset >= sizeof(Header) && op.offset + op.length <= header.index_offset
+                                 : op.offset + op.length <= header.basis_size;
+    if (!valid || op.offset + op.length < op.offset) {
+      input.fail(EINVAL, "delta");
+    }
+    total += op.length;
+  }
+  if (total != header.size) {
+    input.fail(EINVAL, "delta");
+  }
+  return ops;
+}
+
+void CyberDelta::decodeFile(const fs::path& src, const fs::path& basis, const fs::path& dst, const CyberEntry* stat) const {
+  auto input = CyberFile::open(src, O_RDONLY);
+  auto reference = CyberFile::open(basis, O_RDONLY | O_NOFOLLOW);
+  auto ops = readOps(input, reference);
+
+  auto output = CyberFile::open(dst, O_WRONLY | O_CREAT | O_EXCL);
+  try {
+    uint64_t total = 0;
+    for (const auto& op : ops) {
+      copyRange(op.literal != 0 ? input : reference, op.offset, output, total, op.length);
+      total += op.length;
+    }
+    output.resize(static_cast<off_t>(total));
+  } catch (const fs::filesystem_error&) {
+    output.close();
+    ::unlink(dst.c_str());
+    throw;
+  }
+
+  ++counters.decoded;
+  if (stat != nullptr) {
+    output.setStat(*stat);
+  }
+}
+
+uint64_t CyberDelta::readFile(const fs::path& src, const fs::path& basis, const CyberFile::Sink& sink) const {
+  auto input = CyberFile::open(src, O_RDONLY);
+  auto reference = CyberFile::open(basis, O_RDONLY | O_NOFOLLOW);
+  auto ops = readOps(input, reference);
+  posix_fadvise(input.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  thread_local std::vector<unsigned char> buffer(WINDOW);
+  uint64_t total = 0;
+  for (const auto& op : ops) {
+    const auto& from = op.literal != 0 ? input : reference;
+    for (uint64_t done = 0; done < op.length;) {
+      auto wanted = std::min<uint64_t>(op.length - done, buffer.size());
+      if (from.readAt(buffer.data(), wanted, static_cast<off_t>(op.offset + done)) != wanted) {
+        from.fail(EIO, "delta");
+      }
+      sink(buffer.data(), wanted);
+      done += wanted;
+    }
+    total += op.length;
+  }
+  return total;
+}
+
+}  // namespace nt
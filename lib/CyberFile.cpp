@@ -0,0 +1,206 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 11:05 AM
+ *  File    : CyberFile.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberFile.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+timespec toTimespec(int64_t time) noexcept {
+  return {static_cast<time_t>(time / 1'000'000'000), static_cast<long>(time % 1'000'000'000)};
+}
+
+}  // namespace
+
+namespace nt {
+
+CyberFile::CyberFile(int fd, fs::path path) noexcept : fd(fd), path(std::move(path)) {}
+
+CyberFile::CyberFile(CyberFile&& other) noexcept : fd(std::exchange(other.fd, -1)), path(std::move(other.path)) {}
+
+CyberFile& CyberFile::operator=(CyberFile&& other) noexcept {
+  if (this != &other) {
+    close();
+    fd = std::exchange(other.fd, -1);
+    path = std::move(other.path);
+  }
+  return *this;
+}
+
+CyberFile::~CyberFile() {
+  close();
+}
+
+CyberFile CyberFile::open(const fs::path& path, int flags, mode_t mode) {
+  int fd = ::open(path.c_str(), flags | O_CLOEXEC, mode);
+  if (fd == -1) {
+    throw fs::filesystem_error("open", path, std::error_code(errno, std::generic_category()));
+  }
+  return {fd, path};
+}
+
+int CyberFile::get() const noexcept {
+  return fd;
+}
+
+const fs::path& CyberFile::getPath() const noexcept {
+  return path;
+}
+
+off_t CyberFile::size() const {
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) != 0) {
+    fail(errno, "stat");
+  }
+  return file_stat.st_size;
+}
+
+size_t CyberFile::read(void* data, size_t size) const {
+  size_t done = 0;
+  while (done < size) {
+    auto result = ::read(fd, static_cast<char*>(data) + done, size - done);
+    if (result == 0) {
+      break;
+    }
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fail(errno, "read");
+    }
+    done += result;
+  }
+  return done;
+}
+
+size_t CyberFile::readAt(void* data, size_t size, off_t offset) const {
+  size_t done = 0;
+  while (done < size) {
+    auto result = ::pread(fd, static_cast<char*>(data) + done, size - done, offset + static_cast<off_t>(done));
+    if (result == 0) {
+      break;
+    }
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fail(errno, "read");
+    }
+    done += result;
+  }
+  return done;
+}
+
+void CyberFile::write(const void* data, size_t size) const {
+  size_t done = 0;
+  while (done < size) {
+    auto result = ::write(fd, static_cast<const char*>(data) + done, size - done);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fail(errno, "write");
+    }
+    done += result;
+  }
+}
+
+void CyberFile::writeAt(const void* data, size_t size, off_t offset) const {
+  size_t done = 0;
+  while (done < size) {
+    auto result = ::pwrite(fd, static_cast<const char*>(data) + done, size - done, offset + static_cast<off_t>(done));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fail(errno, "write");
+    }
+    done += result;
+  }
+}
+
+bool CyberFile::writeSparse(const void* data, size_t size, off_t offset) const {
+  static constexpr unsigned char ZEROS[4096] = {};
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (size_t pos = 0; pos < size; pos += sizeof(ZEROS)) {
+    if (std::memcmp(bytes + pos, ZEROS, std::min(sizeof(ZEROS), size - pos)) != 0) {
+      writeAt(data, size, offset);
+      return true;
+    }
+  }
+  return false;
+}
+
+void CyberFile::resize(off_t size) const {
+  if (ftruncate(fd, size) != 0) {
+    fail(errno, "truncate");
+  }
+}
+
+void CyberFile::setStat(const CyberEntry& entry) const {
+  int code = 0;
+  if (fchown(fd, entry.uid, entry.gid) != 0) {
+    code = errno;
+  }
+  if (fchmod(fd, entry.mode & 07777) != 0 && code == 0) {
+    code = errno;
+  }
+  timespec times[2] = {toTimespec(entry.atime), toTimespec(entry.mtime)};
+  if (futimens(fd, times) != 0 && code == 0) {
+    code = errno;
+  }
+  if (code != 0) {
+    fail(code, "stat");
+  }
+}
+
+void CyberFile::setOwner(const fs::path& path, const CyberEntry& entry) {
+  if (chown(path.c_str(), entry.uid, entry.gid) != 0) {
+    throw fs::filesystem_error("stat", path, std::error_code(errno, std::generic_category()));
+  }
+}
+
+void CyberFile::setStat(const fs::path& path, const CyberEntry& entry, bool owner) {
+  int code = 0;
+  if (owner && chown(path.c_str(), entry.uid, entry.gid) != 0) {
+    code = errno;
+  }
+  if (chmod(path.c_str(), entry.mode & 07777) != 0 && code == 0) {
+    code = errno;
+  }
+  timespec times[2] = {toTimespec(entry.atime), toTimespec(entry.mtime)};
+  if (utimensat(AT_FDCWD, path.c_str(), times, 0) != 0 && code == 0) {
+    code = errno;
+  }
+  if (code != 0) {
+    throw fs::filesystem_error("stat", path, std::error_code(code, std::generic_category()));
+  }
+}
+
+int CyberFile::release() noexcept {
+  return std::exchange(fd, -1);
+}
+
+void CyberFile::close() noexcept {
+  if (fd != -1) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+void CyberFile::fail(int code, const char* what) const {
+  throw fs::filesystem_error(what, path, std::error_code(code, std::generic_category()));
+}
+
+}  // namespace nt
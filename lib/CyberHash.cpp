@@ -0,0 +1,281 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 10:02 AM
+ *  File    : CyberHash.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberHash.hpp"
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "../include/CyberFile.hpp"
+
+namespace nt {
+
+namespace {
+
+constexpr uint64_t PRIME32 = 0x9E3779B1ULL;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+
+// Stripe s of a block is keyed with SECRET[s .. s + 7], the scramble uses SECRET[24 .. 31] and the
+// two halves of the digest fold the lanes with SECRET[32 .. 39] and SECRET[40 .. 47].
+constexpr auto SECRET = [] {
+  std::array<uint64_t, 48> result{};
+  uint64_t state = 0x6E54686D654E5442ULL;
+  for (auto& value : result) {
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t mixed = state;
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+    value = mixed ^ (mixed >> 31);
+  }
+  return result;
+}();
+
+constexpr uint64_t INITIAL[CyberHash::LANES] = {
+    PRIME32, PRIME64_1, PRIME64_2, 0x165667B19E3779F9ULL, 0x85EBCA77ULL, 0xC2B2AE3DULL, 0x27D4EB2F165667C5ULL, ~PRIME32,
+};
+
+uint64_t read64(const unsigned char* data) noexcept {
+  uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint64_t mix(uint64_t lhs, uint64_t rhs) noexcept {
+  auto product = static_cast<unsigned __int128>(lhs) * rhs;
+  return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+uint64_t avalanche(uint64_t value) noexcept {
+  value ^= value >> 37;
+  value *= 0x165667919E3779F9ULL;
+  return value ^ (value >> 32);
+}
+
+constexpr size_t FILE_BUFFER = 1 << 20;
+
+void accumulateScalar(uint64_t* lanes, const unsigned char* data, size_t stripes) noexcept {
+  for (size_t stripe = 0; stripe < stripes; ++stripe) {
+    for (size_t lane = 0; lane < CyberHash::LANES; ++lane) {
+      uint64_t value = read64(data + stripe * CyberHash::STRIPE + lane * 8);
+      uint64_t key = value ^ SECRET[stripe + lane];
+      lanes[lane ^ 1] += value;
+      lanes[lane] += (key & 0xFFFFFFFFULL) * (key >> 32);
+    }
+  }
+}
+
+void scrambleScalar(uint64_t* lanes) noexcept {
+  for (size_t lane = 0; lane < CyberHash::LANES; ++lane) {
+    lanes[lane] ^= lanes[lane] >> 47;
+    lanes[lane] ^= SECRET[24 + lane];
+    lanes[lane] *= PRIME32;
+  }
+}
+
+// The vector paths compute exactly the scalar lanes: swapping the 64-bit halves of each 128-bit
+// pair is the lane ^ 1 above, and a 32x32 multiply of the low word with the high word is the product.
+#if defined(__x86_64__)
+
+__attribute__((target("avx2"))) void accumulateAvx2(uint64_t* lanes, const unsigned char* data, size_t stripes) noexcept {
+  auto* acc = reinterpret_cast<__m256i*>(lanes);
+  __m256i low = _mm256_loadu_si256(acc), high = _mm256_loadu_si256(acc + 1);
+  for (size_t stripe = 0; stripe < stripes; ++stripe) {
+    const auto* input = reinterpret_cast<const __m256i*>(data + stripe * CyberHash::STRIPE);
+    const auto* secret = reinterpret_cast<const __m256i*>(SECRET.data() + stripe);
+    for (auto* part : {&low, &high}) {
+      __m256i value = _mm256_loadu_si256(input++);
+      __m256i key = _mm256_xor_si256(value, _mm256_loadu_si256(secret++));
+      __m256i product = _mm256_mul_epu32(key, _mm256_srli_epi64(key, 32));
+      __m256i swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+      *part = _mm256_add_epi64(*part, _mm256_add_epi64(swapped, product));
+    }
+  }
+  _mm256_storeu_si256(acc, low);
+  _mm256_storeu_si256(acc + 1, high);
+}
+
+__attribute__((target("avx2"))) void scrambleAvx2(uint64_t* lanes) noexcept {
+  auto* acc = reinterpret_cast<__m256i*>(lanes);
+  const auto* secret = reinterpret_cast<const __m256i*>(SECRET.data() + 24);
+  const __m256i prime = _mm256_set1_epi32(static_cast<int>(PRIME32));
+  for (size_t part = 0; part < 2; ++part) {
+    __m256i value = _mm256_loadu_si256(acc + part);
+    value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+    value = _mm256_xor_si256(value, _mm256_loadu_si256(secret + part));
+    __m256i low = _mm256_mul_epu32(value, prime);
+    __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+    _mm256_storeu_si256(acc + part, _mm256_add_epi64(low, _mm256_slli_epi64(high, 32)));
+  }
+}
+
+#elif defined(__aarch64__)
+
+void accumulateNeon(uint64_t* lanes, const unsigned char* data, size_t stripes) noexcept {
+  uint64x2_t acc[CyberHash::LANES / 2];
+  for (size_t part = 0; part < CyberHash::LANES / 2; ++part) {
+    acc[part] = vld1q_u64(lanes + part * 2);
+  }
+  for (size_t stripe = 0; stripe < stripes; ++stripe) {
+    for (size_t part = 0; part < CyberHash::LANES / 2; ++part) {
+      uint64x2_t value = vreinterpretq_u64_u8(vld1q_u8(data + stripe * CyberHash::STRIPE + part * 16));
+      uint64x2_t key = veorq_u64(value, vld1q_u64(SECRET.data() + stripe + part * 2));
+      uint64x2_t product = vmull_u32(vmovn_u64(key), vshrn_n_u64(key, 32));
+      acc[part] = vaddq_u64(acc[part], vaddq_u64(vextq_u64(value, value, 1), product));
+    }
+  }
+  for (size_t part = 0; part < CyberHash::LANES / 2; ++part) {
+    vst1q_u64(lanes + part * 2, acc[part]);
+  }
+}
+
+void scrambleNeon(uint64_t* lanes) noexcept {
+  for (size_t part = 0; part < CyberHash::LANES / 2; ++part) {
+    uint64x2_t value = vld1q_u64(lanes + part * 2);
+    value = veorq_u64(value, vshrq_n_u64(value, 47));
+    value = veorq_u64(value, vld1q_u64(SECRET.data() + 24 + part * 2));
+    uint64x2_t low = vmull_n_u32(vmovn_u64(value), static_cast<uint32_t>(PRIME32));
+    uint64x2_t high = vmull_n_u32(vshrn_n_u64(value, 32), static_cast<uint32_t>(PRIME32));
+    vst1q_u64(lanes + part * 2, vaddq_u64(low, vshlq_n_u64(high, 32)));
+  }
+}
+
+#endif
+
+struct Kernels {
+  void (*accumulate)(uint64_t*, const unsigned char*, size_t) noexcept;
+  void (*scramble)(uint64_t*) noexcept;
+  const char* name;
+};
+
+// NEON is part of every aarch64 core, AVX2 is checked once at startup.
+const Kernels KERNELS = [] {
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("avx2")) {
+    return Kernels{accumulateAvx2, scrambleAvx2, "avx2"};
+  }
+#elif defined(__aarch64__)
+  return Kernels{accumulateNeon, scrambleNeon, "neon"};
+#endif
+  return Kernels{accumulateScalar, scrambleScalar, "scalar"};
+}();
+
+}  // namespace
+
+std::string CyberHash::Digest::hex() const {
+  static constexpr char DIGITS[] = "0123456789abcdef";
+  std::string result(32, '0');
+  for (size_t ind = 0; ind < 16; ++ind) {
+    result[15 - ind] = DIGITS[(high >> (ind * 4)) & 15];
+    result[31 - ind] = DIGITS[(low >> (ind * 4)) & 15];
+  }
+  return result;
+}
+
+CyberHash::CyberHash() noexcept : buffer() {
+  std::memcpy(acc, INITIAL, sizeof(acc));
+}
+
+void CyberHash::accumulate(uint64_t* lanes, const unsigned char* data, size_t stripes) noexcept {
+  KERNELS.accumulate(lanes, data, stripes);
+}
+
+void CyberHash::scramble(uint64_t* lanes) noexcept {
+  KERNELS.scramble(lanes);
+}
+
+const char* CyberHash::backend() noexcept {
+  return KERNELS.name;
+}
+
+void CyberHash::update(const void* data, size_t size) noexcept {
+  const auto* input = static_cast<const unsigned char*>(data);
+  total += size;
+
+  if (buffered != 0) {
+    size_t fill = std::min(size, BLOCK - buffered);
+    std::memcpy(buffer + buffered, input, fill);
+    buffered += fill;
+    input += fill;
+    size -= fill;
+    if (buffered < BLOCK || size == 0) {
+      return;
+    }
+    accumulate(acc, buffer, STRIPES);
+    scramble(acc);
+    buffered = 0;
+  }
+
+  // A block is only consumed once more input follows it, so digest() always sees a non-empty tail.
+  while (size > BLOCK) {
+    accumulate(acc, input, STRIPES);
+    scramble(acc);
+    input += BLOCK;
+    size -= BLOCK;
+  }
+
+  std::memcpy(buffer, input, size);
+  buffered = size;
+}
+
+CyberHash::Digest CyberHash::digest() const noexcept {
+  uint64_t lanes[LANES];
+  std::memcpy(lanes, acc, sizeof(lanes));
+
+  size_t stripes = buffered / STRIPE;
+  accumulate(lanes, buffer, stripes);
+
+  unsigned char tail[STRIPE] = {};
+  std::memcpy(tail, buffer + stripes * STRIPE, buffered - stripes * STRIPE);
+  accumulate(lanes, tail, 1);
+
+  Digest result;
+  result.low = total * PRIME64_1;
+  result.high = ~total * PRIME64_2;
+  for (size_t lane = 0; lane < LANES; lane += 2) {
+    result.low += mix(lanes[lane] ^ SECRET[32 + lane], lanes[lane + 1] ^ SECRET[33 + lane]);
+    result.high += mix(lanes[lane] ^ SECRET[40 + lane], lanes[lane + 1] ^ SECRET[41 + lane]);
+  }
+  result.low = avalanche(result.low);
+  result.high = avalanche(result.high);
+  return result;
+}
+
+CyberHash::Digest CyberHash::hash(const void* data, size_t size) noexcept {
+  CyberHash state;
+  state.update(data, size);
+  return state.digest();
+}
+
+uint64_t CyberHash::value() const noexcept {
+  auto low = digest().low;
+  return low != 0 ? low : 1;
+}
+
+uint64_t CyberHash::hashFile(const fs::path& path) {
+  thread_local std::vector<unsigned char> buffer(FILE_BUFFER);
+  auto file = CyberFile::open(path, O_RDONLY | O_CLOEXEC);
+  posix_fadvise(file.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  CyberHash state;
+  for (size_t read = 0; (read = file.read(buffer.data(), buffer.size())) != 0;) {
+    state.update(buffer.data(), read);
+  }
+  return state.value();
+}
+
+}  // namespace nt
@@ -0,0 +1,207 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 4:15 PM
+ *  File    : CyberJournal.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberJournal.hpp"
+
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../include/CyberManifest.hpp"
+
+namespace nt {
+
+bool CyberJournal::Less::operator()(std::string_view lhs, std::string_view rhs) const noexcept {
+  return CyberManifest::compare(lhs, rhs) < 0;
+}
+
+CyberJournal::CyberJournal(fs::path root) : root(std::move(root)) {}
+
+bool CyberJournal::load(const fs::path& path) {
+  std::ifstream file(path);
+  std::string magic, name;
+  uint32_t version = 0;
+  if (!(file >> magic >> version >> since >> synced >> std::quoted(name)) || magic != MAGIC || version != VERSION) {
+    return false;
+  }
+  root = name;
+  changes.clear();
+
+  Change change;
+  while (file >> change.time >> change.tree >> std::quoted(name)) {
+    changes.insert_or_assign(changes.end(), std::move(name), change);
+  }
+  return file.eof();
+}
+
+bool CyberJournal::save(const fs::path& path) const {
+  auto temp = path;
+  temp += ".tmp";
+  {
+    std::ofstream file(temp, std::ios::out | std::ios::trunc);
+    file << MAGIC << ' ' << VERSION << ' ' << since << ' ' << synced << ' ' << std::quoted(root.native()) << '\n';
+    for (const auto& [name, change] : changes) {
+      file << change.time << ' ' << change.tree << ' ' << std::quoted(name) << '\n';
+    }
+    if (!file.flush()) {
+      return false;
+    }
+  }
+  std::error_code code;
+  fs::rename(temp, path, code);
+  return !code;
+}
+
+void CyberJournal::record(std::string_view path, bool tree, int64_t time) {
+  auto it = changes.lower_bound(path);
+  if (it == changes.end() || it->first != path) {
+    it = changes.emplace_hint(it, path, Change{time, tree});
+  } else {
+    it->second.time = std::max(it->second.time, time);
+    it->second.tree = it->second.tree || tree;
+  }
+
+  // A tree is walked as a whole, whatever changed below it is part of that walk already.
+  if (it->second.tree) {
+    auto next = std::next(it);
+    while (next != changes.end() && CyberManifest::inside(path, next->first)) {
+      it->second.time = std::max(it->second.time, next->second.time);
+      next = changes.erase(next);
+    }
+  }
+}
+
+void CyberJournal::reset(int64_t time) {
+  changes.clear();
+  since = time;
+}
+
+void CyberJournal::prune(int64_t time) {
+  std::erase_if(changes, [time](const auto& item) { return item.second.time < time; });
+}
+
+void CyberJournal::setSynced(int64_t time) noexcept {
+  synced = time;
+}
+
+const fs::path& CyberJournal::getRoot() const noexcept {
+  return root;
+}
+
+int64_t CyberJournal::getSince() const noexcept {
+  return since;
+}
+
+int64_t CyberJournal::getSynced() const noexcept {
+  return synced;
+}
+
+size_t CyberJournal::size() const noexcept {
+  return changes.size();
+}
+
+int64_t CyberJournal::now() noexcept {
+  timespec time{};
+  clock_gettime(CLOCK_REALTIME, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1'000'000'000 + time.tv_nsec;
+}
+
+void CyberJournal::walk(const CyberManifest& manifest, int64_t from, const CyberScan::Visitor& visit,
+                        const CyberScan::Failure& failed) const {
+  // Hardlinked files are grouped by their inode, which only the disk knows. Their first paths are recorded by
+  // index in the manifest and looked at again like every link.
+  std::unordered_set<size_t> linked;
+  for (size_t ind = 0; ind < manifest.size(); ++ind) {
+    if (auto link = manifest.record(ind).link; link != 0) {
+      linked.insert(ind);
+      linked.insert(link - 1);
+    }
+  }
+
+  std::vector<std::pair<std::string_view, bool>> changed;
+  for (const auto& [name, change] : changes) {
+    if (change.time >= from) {
+      changed.emplace_back(name, change.tree);
+    }
+  }
+
+  // Both lists are sorted the same way, so one merge settles every path. A change which removed a path, turned it
+  // into something else or brought in a whole folder invalidates what the manifest knows below it: skip.
+  std::string skip;
+  bool skipping = false;
+  auto skipped = [&](std::string_view path) { return skipping && CyberManifest::inside(skip, path); };
+
+  size_t pos = 0, next = 0;
+  while (pos < manifest.size() || next < changed.size()) {
+    if (next < changed.size() && (pos == manifest.size() || CyberManifest::compare(changed[next].first, manifest.name(pos)) <= 0)) {
+      auto [path, tree] = changed[next++];
+      bool known = pos < manifest.size() && manifest.name(pos) == path;
+      bool folder = known && manifest.record(pos).type == static_cast<uint8_t>(CyberEntry::Type::DIRECTORY);
+      pos += known ? 1 : 0;
+      if (skipped(path)) {
+        continue;
+      }
+
+      CyberEntry entry;
+      entry.path = path;
+      if (!CyberScan::stat(root / entry.path, entry)) {
+        skip = path;
+        skipping = true;
+        continue;
+      }
+      bool rescan = entry.isDirectory() && (tree || !folder);
+      if (!entry.isDirectory() || rescan) {
+        skip = path;
+        skipping = true;
+      }
+      visit(std::move(entry));
+
+      if (rescan) {
+        auto prefix = std::string(path) + '/';
+        try {
+          CyberScan::walk(
+              root / path,
+              [&](CyberEntry&& child) {
+                child.path.insert(0, prefix);
+                visit(std::move(child));
+              },
+              failed);
+        } catch (const fs::filesystem_error& error) {
+          if (failed) {
+            failed(error);
+          }
+        }
+      }
+      continue;
+    }
+
+    auto ind = pos++;
+    if (skipped(manifest.name(ind))) {
+      continue;
+    }
+    CyberEntry entry;
+    if (linked.contains(ind)) {
+      entry.path = manifest.name(ind);
+      if (!CyberScan::stat(root / entry.path, entry)) {
+        continue;
+      }
+    } else {
+      // The stored state is taken as it is, just like a fresh scan of an untouched entry would report it.
+      entry = manifest.entry(ind);
+      entry.storage = CyberEntry::Storage::PLAIN;
+      entry.origin = 0;
+      entry.hash = 0;
+      entry.nlink = 1;
+    }
+    visit(std::move(entry));
+  }
+}
+
+}  // namespace nt
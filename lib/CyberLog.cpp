@@ -0,0 +1,92 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 11:25 AM
+ *  File    : CyberLog.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberLog.hpp"
+
+#include <fcntl.h>
+
+#include <cstring>
+#include <vector>
+
+namespace nt {
+
+void CyberLog::add(std::string_view first, std::string_view second) {
+  uint32_t sizes[2] = {static_cast<uint32_t>(first.size()), static_cast<uint32_t>(second.size())};
+
+  std::lock_guard lock(mutex);
+  buffer.append(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+  buffer.append(first);
+  buffer.append(second);
+  ++count;
+  if (buffer.size() >= BUFFER) {
+    spill();
+  }
+}
+
+void CyberLog::spill() {
+  // Without a temporary file the list simply stays in memory, it is never worth failing a run for.
+  if (spill_failed) {
+    return;
+  }
+  try {
+    if (file.get() == -1) {
+      file = CyberFile::open(fs::temp_directory_path(), O_TMPFILE | O_RDWR | O_EXCL);
+    }
+    file.writeAt(buffer.data(), buffer.size(), static_cast<off_t>(spilled));
+    spilled += buffer.size();
+    buffer.clear();
+  } catch (const fs::filesystem_error&) {
+    spill_failed = true;
+  }
+}
+
+size_t CyberLog::parse(std::string_view data, const Visitor& visit) {
+  size_t pos = 0;
+  uint32_t sizes[2];
+  while (data.size() - pos >= sizeof(sizes)) {
+    std::memcpy(sizes, data.data() + pos, sizeof(sizes));
+    if (data.size() - pos - sizeof(sizes) < static_cast<uint64_t>(sizes[0]) + sizes[1]) {
+      break;
+    }
+    auto first = data.substr(pos + sizeof(sizes), sizes[0]);
+    auto second = data.substr(pos + sizeof(sizes) + sizes[0], sizes[1]);
+    visit(first, second);
+    pos += sizeof(sizes) + sizes[0] + sizes[1];
+  }
+  return pos;
+}
+
+void CyberLog::replay(const Visitor& visit) const {
+  std::lock_guard lock(mutex);
+
+  // A pair cut by the end of a block is carried over to the front of the next one.
+  std::vector<char> block;
+  size_t kept = 0;
+  for (uint64_t offset = 0; offset < spilled;) {
+    block.resize(std::max(BUFFER, kept * 2));
+    auto length = file.readAt(block.data() + kept, block.size() - kept, static_cast<off_t>(offset));
+    if (length == 0) {
+      break;
+    }
+    offset += length;
+    length += kept;
+    auto used = parse({block.data(), length}, visit);
+    kept = length - used;
+    std::memmove(block.data(), block.data() + used, kept);
+  }
+  parse(buffer, visit);
+}
+
+size_t CyberLog::size() const noexcept {
+  return count.load();
+}
+
+bool CyberLog::empty() const noexcept {
+  return size() == 0;
+}
+
+}  // namespace nt
@@ -0,0 +1,278 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 16 October 2026, 2:05 PM
+ *  File    : CyberManifest.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberManifest.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace nt {
+
+static_assert(sizeof(CyberManifest::Header) == 32);
+static_assert(sizeof(CyberManifest::Record) == 64);
+
+CyberManifest::~CyberManifest() {
+  close();
+}
+
+bool CyberManifest::open(const fs::path& path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(Header)) {
+    ::close(fd);
+    return false;
+  }
+
+  data_size = file_stat.st_size;
+  data = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    data = nullptr;
+    return false;
+  }
+
+  const auto* header = static_cast<const Header*>(data);
+  if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) {
+    close();
+    return false;
+  }
+
+  size_t body = data_size - sizeof(Header);
+  if (header->count > body / sizeof(Record) ||
+      header->origins > (body - header->count * sizeof(Record)) / ORIGIN_SIZE ||
+      header->names_size != body - header->count * sizeof(Record) - header->origins * ORIGIN_SIZE) {
+    close();
+    return false;
+  }
+
+  count = header->count;
+  origin_count = header->origins;
+  records = reinterpret_cast<const Record*>(static_cast<const char*>(data) + sizeof(Header));
+  names = reinterpret_cast<const char*>(records + count);
+  origins = names + header->names_size;
+  for (size_t ind = 0; ind < count; ++ind) {
+    const auto& record = records[ind];
+    if (record.name_offset > header->names_size || record.name_size > header->names_size - record.name_offset ||
+        record.origin >= std::max<size_t>(origin_count, 1) || record.link > ind) {
+      close();
+      return false;
+    }
+  }
+
+  madvise(data, data_size, MADV_SEQUENTIAL);
+  return true;
+}
+
+void CyberManifest::close() noexcept {
+  if (data != nullptr) {
+    munmap(data, data_size);
+  }
+  data = nullptr;
+  data_size = 0;
+  records = nullptr;
+  names = nullptr;
+  origins = nullptr;
+  count = 0;
+  origin_count = 0;
+}
+
+bool CyberManifest::isOpen() const noexcept {
+  return data != nullptr;
+}
+
+size_t CyberManifest::size() const noexcept {
+  return count;
+}
+
+const CyberManifest::Record& CyberManifest::record(size_t ind) const noexcept {
+  return records[ind];
+}
+
+std::string_view CyberManifest::name(size_t ind) const noexcept {
+  return {names + records[ind].name_offset, records[ind].name_size};
+}
+
+size_t CyberManifest::originCount() const noexcept {
+  return origin_count;
+}
+
+std::string_view CyberManifest::origin(size_t ind) const noexcept {
+  if (ind >= origin_count) {
+    return {};
+  }
+  std::string_view result(origins + ind * ORIGIN_SIZE, ORIGIN_SIZE);
+  return result.substr(0, result.find('\0'));
+}
+
+CyberEntry CyberManifest::entry(size_t ind) const {
+  const auto& from = records[ind];
+  CyberEntry result;
+  result.path = name(ind);
+  result.type = static_cast<CyberEntry::Type>(from.type);
+  result.storage = static_cast<CyberEntry::Storage>(from.storage);
+  result.origin = from.origin;
+  result.mode = from.mode;
+  result.uid = from.uid;
+  result.gid = from.gid;
+  result.size = from.size;
+  result.atime = from.atime;
+  result.mtime = from.mtime;
+  result.hash = from.hash;
+  if (from.link != 0) {
+    result.link = name(from.link - 1);
+  }
+  return result;
+}
+
+size_t CyberManifest::find(std::string_view path) const noexcept {
+  size_t left = 0, right = count;
+  while (left < right) {
+    size_t middle = left + (right - left) / 2;
+    if (compare(name(middle), path) < 0) {
+      left = middle + 1;
+    } else {
+      right = middle;
+    }
+  }
+  return left < count && name(left) == path ? left : count;
+}
+
+std::pair<size_t, size_t> CyberManifest::subtree(std::string_view path) const noexcept {
+  auto first = find(path);
+  if (first == count) {
+    return {count, count};
+  }
+  // '/' sorts first, so the subtree directly follows path and ends at the first record outside of it.
+  size_t left = first + 1, right = count;
+  while (left < right) {
+    size_t middle = left + (right - left) / 2;
+    if (inside(path, name(middle))) {
+      left = middle + 1;
+    } else {
+      right = middle;
+    }
+  }
+  return {first, left};
+}
+
+CyberManifest::Writer::~Writer() {
+  if (!path.empty()) {
+    std::error_code code;
+    fs::remove(tempPath(".tmp"), code);
+    fs::remove(tempPath(".names"), code);
+  }
+}
+
+fs::path CyberManifest::Writer::tempPath(const char* suffix) const {
+  auto result = path;
+  result += suffix;
+  return result;
+}
+
+bool CyberManifest::Writer::open(const fs::path& value) {
+  path = value;
+  records.open(tempPath(".tmp"), std::ios::out | std::ios::binary | std::ios::trunc);
+  names.open(tempPath(".names"), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+  Header header{};
+  records.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return records.good() && names.good();
+}
+
+size_t CyberManifest::Writer::add(const CyberEntry& entry, uint32_t link) {
+  Record record{};
+  record.name_offset = names_size;
+  record.name_size = entry.path.size();
+  record.size = entry.size;
+  record.mtime = entry.mtime;
+  record.atime = entry.atime;
+  record.hash = entry.hash;
+  record.mode = entry.mode;
+  record.uid = entry.uid;
+  record.gid = entry.gid;
+  record.type = static_cast<uint8_t>(entry.type);
+  record.storage = static_cast<uint8_t>(entry.storage);
+  record.origin = entry.origin;
+  record.link = link;
+  records.write(reinterpret_cast<const char*>(&record), sizeof(record));
+  names.write(entry.path.data(), static_cast<std::streamsize>(entry.path.size()));
+  names_size += entry.path.size();
+  return count++;
+}
+
+bool CyberManifest::Writer::finish(const std::vector<std::string>& origins) {
+  std::vector<char> block(1 << 20);
+  names.seekg(0);
+  for (uint64_t left = names_size; left != 0 && names && records;) {
+    auto length = static_cast<std::streamsize>(std::min<uint64_t>(left, block.size()));
+    names.read(block.data(), length);
+    records.write(block.data(), names.gcount());
+    left -= static_cast<uint64_t>(names.gcount());
+    if (names.gcount() == 0) {
+      break;
+    }
+  }
+  for (const auto& origin : origins) {
+    char name[ORIGIN_SIZE] = {};
+    origin.copy(name, ORIGIN_SIZE - 1);
+    records.write(name, ORIGIN_SIZE);
+  }
+
+  Header header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.count = count;
+  header.names_size = names_size;
+  header.origins = origins.size();
+  records.seekp(0);
+  records.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  bool written = names.good() && records.flush().good();
+  records.close();
+  names.close();
+
+  std::error_code code;
+  fs::remove(tempPath(".names"), code);
+  if (written) {
+    fs::rename(tempPath(".tmp"), path, code);
+  }
+  return written && !code;
+}
+
+int CyberManifest::compare(std::string_view lhs, std::string_view rhs) noexcept {
+  // '/' sorts before every other byte, which keeps each directory directly followed by its own subtree.
+  size_t length = std::min(lhs.size(), rhs.size());
+  for (size_t ind = 0; ind < length; ++ind) {
+    unsigned char left = lhs[ind] == '/' ? 0 : lhs[ind];
+    unsigned char right = rhs[ind] == '/' ? 0 : rhs[ind];
+    if (left != right) {
+      return left < right ? -1 : 1;
+    }
+  }
+  return lhs.size() == rhs.size() ? 0 : (lhs.size() < rhs.size() ? -1 : 1);
+}
+
+bool CyberManifest::inside(std::string_view root, std::string_view path) noexcept {
+  return path.starts_with(root) && (path.size() == root.size() || path[root.size()] == '/');
+}
+
+void CyberManifest::sort(std::vector<CyberEntry>& entries) {
+  std::sort(entries.begin(), entries.end(),
+            [](const CyberEntry& lhs, const CyberEntry& rhs) { return compare(lhs.path, rhs.path) < 0; });
+}
+
+}  // namespace nt
@@ -0,0 +1,216 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 18 October 2026, 5:05 PM
+ *  File    : CyberPack.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberPack.hpp"
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace nt {
+
+void CyberPacker::prepare(const fs::path& value) const {
+  fs::create_directories(value);
+  root = value;
+}
+
+const CyberPacker::Counters& CyberPacker::getCounters() const noexcept {
+  return counters;
+}
+
+std::string CyberPacker::describe() const {
+  return "packed: " + std::to_string(counters.packed.load()) + ", unpacked: " + std::to_string(counters.unpacked.load()) +
+         ", segments: " + std::to_string(counters.segments.load()) + ", bytes: " + std::to_string(counters.bytes.load());
+}
+
+std::unique_ptr<CyberPacker::Segment> CyberPacker::acquire() const {
+  {
+    std::lock_guard lock(mutex);
+    if (!idle.empty()) {
+      auto segment = std::move(idle.back());
+      idle.pop_back();
+      return segment;
+    }
+  }
+
+  std::ostringstream name;
+  name << std::setw(6) << std::setfill('0') << next++ << EXTENSION;
+  auto segment = std::make_unique<Segment>();
+  segment->file = CyberFile::open(root / name.str(), O_WRONLY | O_CREAT | O_EXCL);
+  segment->buffer.reserve(BUFFER);
+  ++counters.segments;
+  return segment;
+}
+
+void CyberPacker::release(std::unique_ptr<Segment> segment) const {
+  std::lock_guard lock(mutex);
+  idle.push_back(std::move(segment));
+}
+
+void CyberPacker::flush(Segment& segment) {
+  if (segment.buffer.empty()) {
+    return;
+  }
+  segment.file.writeAt(segment.buffer.data(), segment.buffer.size(),
+                       static_cast<off_t>(segment.end - segment.buffer.size()));
+  segment.buffer.clear();
+}
+
+void CyberPacker::close(Segment& segment) {
+  flush(segment);
+
+  Header header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.count = segment.items.size();
+  header.index_offset = segment.end;
+  header.names_size = segment.names.size();
+
+  auto index_size = segment.items.size() * sizeof(Item);
+  segment.file.writeAt(segment.items.data(), index_size, static_cast<off_t>(segment.end));
+  segment.file.writeAt(segment.names.data(), segment.names.size(), static_cast<off_t>(segment.end + index_size));
+  segment.file.writeAt(&header, sizeof(header), 0);
+  segment.file.close();
+}
+
+void CyberPacker::append(const fs::path& src, const CyberEntry& entry) const {
+  auto input = CyberFile::open(src, O_RDONLY | O_NOFOLLOW);
+  // A file which grew since the scan is cut at its scanned size, the manifest describes that one.
+  store(entry, std::min<uint64_t>(entry.size, MAX_SIZE),
+        [&input](unsigned char* data, size_t size) { return input.read(data, size); });
+}
+
+void CyberPacker::append(const CyberEntry& entry, const unsigned char* data, size_t size) const {
+  store(entry, std::min(size, MAX_SIZE), [data](unsigned char* to, size_t size) {
+    std::memcpy(to, data, size);
+    return size;
+  });
+}
+
+void CyberPacker::store(const CyberEntry& entry, size_t size, const Filler& fill) const {
+  auto segment = acquire();
+  size_t used = 0;
+  try {
+    // A segment which fails to close or flush is dropped rather than handed to the next writer. The files it holds
+    // already are gone with it.
+    if (!segment->items.empty() && segment->end + size > SEGMENT_SIZE) {
+      auto full = std::move(segment);
+      try {
+        close(*full);
+      } catch (const fs::filesystem_error&) {
+        lost = true;
+        throw;
+      }
+      segment = acquire();
+    }
+    if (segment->buffer.size() + size > BUFFER) {
+      auto full = std::move(segment);
+      try {
+        flush(*full);
+      } catch (const fs::filesystem_error&) {
+        lost = true;
+        throw;
+      }
+      segment = std::move(full);
+    }
+
+    used = segment->buffer.size();
+    segment->buffer.resize(used + size);
+    size = fill(segment->buffer.data() + used, size);
+    segment->buffer.resize(used + size);
+  } catch (const fs::filesystem_error&) {
+    if (segment != nullptr) {
+      segment->buffer.resize(std::min(segment->buffer.size(), used));
+      release(std::move(segment));
+    }
+    throw;
+  }
+
+  segment->items.push_back({segment->end, size, entry.mtime, segment->names.size(), static_cast<uint32_t>(entry.path.size()),
+                            entry.mode, entry.uid, entry.gid});
+  segment->names += entry.path;
+  segment->end += size;
+  ++counters.packed;
+  counters.bytes += size;
+  release(std::move(segment));
+}
+
+void CyberPacker::finish() const {
+  std::vector<std::unique_ptr<Segment>> segments;
+  {
+    std::lock_guard lock(mutex);
+    segments.swap(idle);
+  }
+  for (auto& segment : segments) {
+    close(*segment);
+  }
+  if (lost) {
+    throw fs::filesystem_error("pack", root, std::error_code(EIO, std::generic_category()));
+  }
+}
+
+void CyberPacker::readSegment(const fs::path& segment, const Visitor& visit) const {
+  auto file = CyberFile::open(segment, O_RDONLY);
+  posix_fadvise(file.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  Header header{};
+  auto total = static_cast<uint64_t>(file.size());
+  if (file.readAt(&header, sizeof(header), 0) != sizeof(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != VERSION || header.index_offset < sizeof(Header) || header.index_offset > total ||
+      header.count > (total - header.index_offset) / sizeof(Item) ||
+      header.names_size != total - header.index_offset - header.count * sizeof(Item)) {
+    file.fail(EINVAL, "segment");
+  }
+
+  std::vector<Item> items(header.count);
+  std::string names(header.names_size, '\0');
+  auto index_size = items.size() * sizeof(Item);
+  if (file.readAt(items.data(), index_size, static_cast<off_t>(header.index_offset)) != index_size ||
+      file.readAt(names.data(), names.size(), static_cast<off_t>(header.index_offset + index_size)) != names.size()) {
+    file.fail(EINVAL, "segment");
+  }
+  for (const auto& item : items) {
+    if (item.offset < sizeof(Header) || item.size > MAX_SIZE || item.offset + item.size > header.index_offset ||
+        item.name_offset > names.size() || item.name_size > names.size() - item.name_offset) {
+      file.fail(EINVAL, "segment");
+    }
+  }
+  std::sort(items.begin(), items.end(), [](const Item& lhs, const Item& rhs) { return lhs.offset < rhs.offset; });
+
+  // Files are served out of one window which is refilled whenever the next file is not completely inside it.
+  thread_local std::vector<unsigned char> window(WINDOW);
+  uint64_t start = 0, length = 0;
+  for (const auto& item : items) {
+    if (item.offset < start || item.offset + item.size > start + length) {
+      start = item.offset;
+      length = file.readAt(window.data(), std::min<uint64_t>(window.size(), header.index_offset - start),
+                           static_cast<off_t>(start));
+      if (length < item.size) {
+        file.fail(EINVAL, "segment");
+      }
+    }
+    visit(item, std::string_view(names).substr(item.name_offset, item.name_size), window.data() + (item.offset - start));
+    ++counters.unpacked;
+  }
+}
+
+std::vector<fs::path> CyberPacker::listSegments(const fs::path& root) {
+  std::vector<fs::path> result;
+  std::error_code code;
+  for (const auto& entry : fs::directory_iterator(root, code)) {
+    if (entry.path().extension() == EXTENSION) {
+      result.push_back(entry.path());
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+}  // namespace nt
@@ -0,0 +1,174 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 16 October 2026, 10:12 AM
+ *  File    : CyberPool.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberPool.hpp"
+
+#include <algorithm>
+#include <exception>
+
+namespace nt {
+
+namespace {
+
+thread_local CyberPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+}  // namespace
+
+CyberPool::CyberPool(size_t jobs, const std::atomic<bool>* cancelled) : cancelled(cancelled) {
+  jobs = std::max<size_t>(jobs, 1);
+  for (size_t ind = 0; ind < jobs; ++ind) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t ind = 0; ind < jobs; ++ind) {
+    workers.emplace_back(&CyberPool::run, this, ind);
+  }
+}
+
+CyberPool::~CyberPool() {
+  wait();
+  {
+    std::lock_guard lock(mutex);
+    stop = true;
+  }
+  wake.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+size_t CyberPool::size() const noexcept {
+  return queues.size();
+}
+
+size_t CyberPool::defaultJobs() noexcept {
+  return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void CyberPool::submit(Task task) {
+  ++pending;
+
+  // Tasks spawned by a worker stay on its own deque, everything else is spread round-robin.
+  size_t ind = current_pool == this ? current_worker : next++ % queues.size();
+  {
+    std::lock_guard lock(queues[ind]->mutex);
+    queues[ind]->tasks.push_back(std::move(task));
+  }
+  ++queued;
+
+  { std::lock_guard lock(mutex); }
+  wake.notify_one();
+}
+
+void CyberPool::split(size_t count, const std::function<void(size_t)>& body) {
+  struct Split {
+    std::function<void(size_t)> body;
+    size_t count;
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> done = 0;
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+
+    void run() {
+      for (size_t ind; (ind = next++) < count;) {
+        try {
+          body(ind);
+        } catch (...) {
+          std::lock_guard lock(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+        if (++done == count) {
+          std::lock_guard lock(mutex);
+          finished.notify_all();
+        }
+      }
+    }
+  };
+
+  if (count == 0) {
+    return;
+  }
+
+  // Helpers may start after the loop is over, so they share ownership of its state and just find nothing left.
+  auto state = std::make_shared<Split>();
+  state->body = body;
+  state->count = count;
+  if (current_pool != nullptr) {
+    for (size_t ind = 1; ind < std::min(count, current_pool->size()); ++ind) {
+      current_pool->submit([state](size_t) { state->run(); });
+    }
+  }
+  state->run();
+
+  std::unique_lock lock(state->mutex);
+  state->finished.wait(lock, [&state] { return state->done.load() == state->count; });
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+void CyberPool::wait() {
+  std::unique_lock lock(mutex);
+  idle.wait(lock, [this] { return pending.load() == 0; });
+}
+
+bool CyberPool::pop(size_t ind, Task& task) {
+  {
+    auto& own = *queues[ind];
+    std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      --queued;
+      return true;
+    }
+  }
+
+  for (size_t shift = 1; shift < queues.size(); ++shift) {
+    auto& other = *queues[(ind + shift) % queues.size()];
+    std::lock_guard lock(other.mutex);
+    if (!other.tasks.empty()) {
+      task = std::move(other.tasks.front());
+      other.tasks.pop_front();
+      --queued;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void CyberPool::run(size_t ind) {
+  current_pool = this;
+  current_worker = ind;
+
+  Task task;
+  while (true) {
+    if (pop(ind, task)) {
+      if (cancelled == nullptr || !cancelled->load(std::memory_order_relaxed)) {
+        task(ind);
+      }
+      task = nullptr;
+      if (--pending == 0) {
+        std::lock_guard lock(mutex);
+        idle.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock lock(mutex);
+    wake.wait(lock, [this] { return stop || queued.load() > 0; });
+    if (stop && queued.load() == 0) {
+      return;
+    }
+  }
+}
+
+}  // namespace nt
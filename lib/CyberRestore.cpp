@@ -7,31 +7,86 @@
 
 #include "../include/CyberRestore.hpp"
 
-#include <cstring>
+#include <fcntl.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <fstream>
-#include <list>
+#include <map>
 #include <ranges>
 #include <unordered_set>
 
+#include "../include/CyberFile.hpp"
+#include "../include/CyberHash.hpp"
+#include "../include/CyberManifest.hpp"
+#include "../include/CyberPool.hpp"
+
 namespace nt {
 
+namespace {
+
+// What verify found for one entry. Everything after UNHASHED is a problem.
+enum class Check {
+  VERIFIED,
+  UNHASHED,
+  MISSING,
+  TRUNCATED,
+  MISMATCHED,
+  CORRUPTED,
+  COUNT,
+};
+
+uint64_t readPlain(const fs::path& path, size_t block, const CyberFile::Sink& sink) {
+  thread_local std::vector<unsigned char> buffer;
+  buffer.resize(block);
+  auto file = CyberFile::open(path, O_RDONLY | O_NOFOLLOW);
+  posix_fadvise(file.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  uint64_t total = 0;
+  for (size_t read = 0; (read = file.read(buffer.data(), buffer.size())) != 0;) {
+    sink(buffer.data(), read);
+    total += read;
+  }
+  return total;
+}
+
+}  // namespace
+
 CyberRestore::CyberRestore(int argc, const char** argv) {
   type = argv[1];
   if (argc == 2 && type == "help") {
     std::cout << "Usage: my_restore [SOURCE] [DESTINATION] [OPTIONAL FLAGS]\n"
+                 "       my_restore verify [SOURCE] [OPTIONAL FLAGS]\n"
                  "A tool for restoring the backup of your files and folders from SOURCE timestamp name folder to DESTINATION"
                  " which was created by my_backup.\n"
-                 "\nTwo backup types are available: full and incremental.\n"
+                 "verify reads SOURCE and every backup it depends on back without restoring them and reports files which are"
+                 " missing, truncated, unreadable or do not match the checksum taken by 'my_backup ... hash'.\n"
+                 "\nFour backup types are available: full, incremental, chain and snapshot.\n"
                  "  full             creates a full backup copy of the SOURCE\n"
                  "  incremental      creates a copy of the SOURCE with differences between current state and last full backup\n"
+                 "  chain            creates a copy of the SOURCE with differences between current state and last backup\n"
+                 "  snapshot         creates a complete tree of the SOURCE whose unchanged files are hardlinks to the last backup\n"
                  "\nOptions\n"
                  "  create       Create a backup folder if it does not exist\n"
                  "  override     Remove files from DESTINATION or override them\n"
+                 "  merge        Restore into a non-empty DESTINATION, replacing only the entries the backup holds\n"
+                 "  path=<PATH>  Restore only PATH of the backup, a file or a folder with everything below it\n"
                  "  full_info    Display a backup information after process\n"
                  "  error_info   Display info only about errors\n"
                  "  silent       Silent mode (do not show errors)\n"
                  "  process      Show progress status\n"
                  "  ignore       Continue restoring despite errors\n"
+                 "  jobs=<N>     Copy files with N threads (default: number of CPU cores)\n"
+                 "  copy=<MODE>  File copy mode: auto, reflink, kernel or buffer (default: auto)\n"
+                 "  progress     Show a live progress line with throughput and ETA on stderr\n"
+                 "  report=<FILE> Write phase timings, totals and size and latency histograms to FILE as JSON\n"
+                 "\nVerify options\n"
+                 "  rate=<N>     Read at most N bytes per second, K, M or G for KiB, MiB or GiB (e.g. rate=200M)\n"
+                 "  files=<N>    Open at most N files per second\n"
+                 "  io=<CLASS>   I/O priority: idle, best-effort or best-effort:<0-7> (best-effort alone is level 7)\n"
+                 "  latency=<MS> Read fewer files at once while reads of the backup device take longer than MS\n"
+                 "               milliseconds on average ('us' suffix for microseconds)\n"
               << std::endl;
     std::exit(0);
   }
@@ -46,34 +101,113 @@ CyberRestore::CyberRestore(int argc, const char** argv) {
           "Missing a path of the entity to restore. Try 'my_restore help' for more information.");
   }
 
-  source = argv[1];
-  if (argc == 2) {
-    abort(static_cast<int>(std::errc::invalid_argument),
-          "Missing a destination path of the entity to restore. Try 'my_restore help' for more information.");
+  // Verify takes the backup in place of the source and has no destination.
+  verifying = type == "verify";
+  if (verifying) {
+    source = argv[2];
+  } else {
+    source = argv[1];
+    destination = argv[2];
   }
-
-  destination = argv[2];
   params = static_cast<int>(Parameter::REMOVE_INSIDE_ONLY);
+  jobs = CyberPool::defaultJobs();
   for (int ind = 3; ind < argc; ++ind) {
-    if (std::string(argv[ind]) == "create") {
+    std::string operand = argv[ind];
+    if (verifying && (operand == "create" || operand == "override" || operand == "merge" || operand == "ignore" ||
+                      operand.starts_with("copy="))) {
+      abort(static_cast<int>(std::errc::invalid_argument),
+            "Operand '" + operand + "' does not apply to verify. Try 'my_restore help' for more information.");
+    }
+    if (parseSchedule(operand)) {
+      if (!verifying) {
+        abort(static_cast<int>(std::errc::invalid_argument),
+              "Operand '" + operand + "' only applies to verify. Try 'my_restore help' for more information.");
+      }
+      continue;
+    }
+
+    if (operand == "create") {
       params |= static_cast<int>(Parameter::CREATE_DESTINATION);
-    } else if (std::string(argv[ind]) == "override") {
+    } else if (operand == "override") {
       params |= static_cast<int>(Parameter::OVERRIDE_DESTINATION);
-    } else if (std::string(argv[ind]) == "ignore") {
+    } else if (operand == "merge") {
+      params |= static_cast<int>(Parameter::MERGE_DESTINATION);
+    } else if (operand.starts_with("path=")) {
+      auto path = fs::path(operand.substr(5)).relative_path().lexically_normal().string();
+      while (!path.empty() && path.back() == '/') {
+        path.pop_back();
+      }
+      if (path == "..") {
+        abort(static_cast<int>(std::errc::invalid_argument),
+              "Wrong path '" + operand.substr(5) + "'. It has to stay inside the backup.");
+      }
+      selected = path == "." ? "" : path;
+    } else if (operand == "ignore") {
       params |= static_cast<int>(Parameter::IGNORE_ERRORS);
-    } else if (std::string(argv[ind]) == "full_info") {
+    } else if (operand == "full_info") {
       params |= static_cast<int>(Parameter::SHOW_BACKUP_STAT) | static_cast<int>(Parameter::SHOW_ERROR_STAT);
-    } else if (std::string(argv[ind]) == "error_info") {
+    } else if (operand == "error_info") {
       params |= static_cast<int>(Parameter::SHOW_ERROR_STAT);
-    } else if (std::string(argv[ind]) == "silent") {
+    } else if (operand == "silent") {
       params |= static_cast<int>(Parameter::SILENT);
-    } else if (std::string(argv[ind]) == "process") {
+    } else if (operand == "process") {
       params |= static_cast<int>(Parameter::PROCESS);
+    } else if (operand.starts_with("jobs=")) {
+      jobs = parseJobs(operand.substr(5));
+    } else if (operand.starts_with("copy=")) {
+      copier.setMode(parseCopyMode(operand.substr(5)));
+    } else if (operand == "progress") {
+      stats.setProgress(true);
+    } else if (operand.starts_with("report=")) {
+      report = operand.substr(7);
     } else {
       abort(static_cast<int>(std::errc::invalid_argument),
-            "Wrong operand. Did you mean 'create, 'override', 'full_info', 'error_info', 'silent', 'process' or 'ignore'?");
+            "Wrong operand '" + operand + "'. Try 'my_restore help' for more information.");
+    }
+  }
+
+  // A merge keeps what is already in the destination, so an abort must not wipe it.
+  if (getParam(params, Parameter::MERGE_DESTINATION)) {
+    params = nullifyParams(params, Parameter::REMOVE_INSIDE_ONLY);
+  }
+
+  auto backup_dir = fs::absolute(source).lexically_normal();
+  if (!backup_dir.has_filename()) {
+    backup_dir = backup_dir.parent_path();
+  }
+  chunks.setRoot(backup_dir.parent_path() / CHUNK_NAME);
+  startScheduler(backup_dir);
+}
+
+std::pair<size_t, size_t> CyberRestore::selectEntries(const std::vector<fs::path>& layers, const CyberManifest& manifest,
+                                                      bool chained, const std::vector<std::string>& deleted,
+                                                      std::vector<CyberEntry>& merged) const {
+  size_t first = 0, last = 0;
+  if (chained) {
+    std::tie(first, last) = selected.empty() ? std::pair<size_t, size_t>{0, manifest.size()} : manifest.subtree(selected);
+  } else {
+    merged = mergeBackup(layers, manifest, deleted);
+    // Backups without a manifest have no index, their selection is filtered out of the complete walk.
+    if (!selected.empty()) {
+      std::erase_if(merged, [this](const CyberEntry& entry) { return !CyberManifest::inside(selected, entry.path); });
+    }
+    last = merged.size();
+  }
+
+  uint64_t total_bytes = 0;
+  for (size_t ind = first; ind < last; ++ind) {
+    if (chained ? manifest.record(ind).type == static_cast<uint8_t>(CyberEntry::Type::FILE) : merged[ind].isFile()) {
+      total_bytes += chained ? manifest.record(ind).size : merged[ind].size;
     }
   }
+  stats.setTotal(last - first, total_bytes);
+
+  if (!selected.empty() && first == last) {
+    abort(static_cast<int>(std::errc::no_such_file_or_directory),
+          "Path (" + selected + ") is not part of the backup. Please check the path.",
+          nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+  }
+  return {first, last};
 }
 
 void CyberRestore::process() const noexcept {
@@ -83,38 +217,93 @@ void CyberRestore::process() const noexcept {
           nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
   }
 
-  std::ifstream sum_file(source / SUM_NAME);
-  if (!sum_file.is_open()) {
-    abort(static_cast<int>(std::errc::no_such_file_or_directory),
-          "Cannot open summary file. Try to use other or recreate backup.",
-          nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+  auto source_norm = fs::canonical(fs::absolute(source));
+
+  // The catalog next to the backup knows its type and base. The summary is read for backups it does not list and for
+  // the deletions of a backup without a chained manifest.
+  std::ifstream sum_file;
+  std::string backup_type, base_timestamp;
+  auto open_summary = [&] {
+    sum_file.open(source / SUM_NAME);
+    if (!sum_file.is_open()) {
+      abort(static_cast<int>(std::errc::no_such_file_or_directory),
+            "Cannot open summary file. Try to use other or recreate backup.",
+            nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+    }
+
+    if (!(sum_file >> backup_type)) {
+      sum_file.close();
+      abort(static_cast<int>(std::errc::invalid_argument), "Source file is empty.",
+            nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+    }
+
+    if (!(sum_file >> base_timestamp) || !isTimestamp(base_timestamp)) {
+      sum_file.close();
+      abort(static_cast<int>(std::errc::invalid_argument), "Timestamp is corrupted.",
+            nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+    }
+  };
+
+  CyberCatalog catalog(source_norm.parent_path() / CATALOG_NAME);
+  CyberCatalog::Record cataloged;
+  auto is_source = [&source_norm](const CyberCatalog::Record& item) {
+    return item.id == source_norm.filename().native() && item.status == CyberCatalog::COMPLETE;
+  };
+  if (catalog.findLast(is_source, cataloged) && isTimestamp(cataloged.base)) {
+    backup_type = cataloged.type;
+    base_timestamp = cataloged.base;
+  } else {
+    open_summary();
   }
 
-  std::string full_backup_timestamp;
-  if (!(sum_file >> full_backup_timestamp)) {
+  // The manifest of a backup names the backup holding every entry, so the whole chain is restored from it alone.
+  // Backups without one are restored from their own tree laid over the tree of their full backup.
+  std::vector<fs::path> layers{source_norm};
+  CyberManifest source_manifest;
+  bool chained = source_manifest.open(source_norm / MAN_NAME) && source_manifest.originCount() != 0;
+  if (chained) {
+    for (size_t ind = 1; ind < source_manifest.originCount(); ++ind) {
+      layers.push_back(source_norm.parent_path() / source_manifest.origin(ind));
+      if (!fs::is_directory(layers.back() / DIR_NAME)) {
+        sum_file.close();
+        abort(static_cast<int>(std::errc::no_such_file_or_directory),
+              "Backup entity (" + layers.back().string() + ") of the chain does not exist. Please use other backup.",
+              nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+      }
+    }
+  } else if (backup_type == "chain" || backup_type == "snapshot") {
     sum_file.close();
-    abort(static_cast<int>(std::errc::invalid_argument), "Source file is empty.",
+    abort(static_cast<int>(std::errc::invalid_argument), "Manifest of the " + backup_type + " backup is missing or corrupted.",
           nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+  } else {
+    fs::path full_backup_norm = source.parent_path() / base_timestamp;
+    if (!fs::is_directory(full_backup_norm / DIR_NAME)) {
+      sum_file.close();
+      abort(static_cast<int>(std::errc::no_such_file_or_directory),
+            "Full backup entity (" + full_backup_norm.string() + ") does not exist. Please use other backup.",
+            nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+    }
+
+    full_backup_norm = fs::canonical(fs::absolute(full_backup_norm));
+    if (full_backup_norm != source_norm) {
+      layers.push_back(full_backup_norm);
+    }
   }
 
-  if (!(sum_file >> full_backup_timestamp) && !std::regex_match(full_backup_timestamp, timestamp_pattern)) {
-    sum_file.close();
-    abort(static_cast<int>(std::errc::invalid_argument), "Timestamp is corrupted.",
-          nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+  std::vector<std::string> deleted;
+  if (!chained) {
+    if (!sum_file.is_open()) {
+      open_summary();
+    }
+    deleted = readDeleted(sum_file, base_timestamp);
   }
   sum_file.close();
 
-  fs::path full_backup_norm = source.parent_path() / full_backup_timestamp;
-  if (!fs::is_directory(full_backup_norm / DIR_NAME)) {
-    abort(static_cast<int>(std::errc::no_such_file_or_directory),
-          "Full backup entity (" + full_backup_norm.string() + ") does not exist. Please use other backup.",
-          nullifyParams(params, Parameter::IGNORE_ERRORS, Parameter::REMOVE_INSIDE_ONLY));
+  if (verifying) {
+    verify(source_norm, layers, source_manifest, chained, deleted, backup_type);
+    return;
   }
 
-  full_backup_norm = fs::canonical(fs::absolute(full_backup_norm));
-  std::unordered_set<std::string> to_remove((std::istream_iterator<std::string>(sum_file)),
-                                            std::istream_iterator<std::string>());
-
   if (!fs::is_directory(destination)) {
     if (!getParam(params, Parameter::CREATE_DESTINATION)) {
       abort(static_cast<int>(std::errc::no_such_file_or_directory),
@@ -135,7 +324,9 @@ void CyberRestore::process() const noexcept {
     }
 
     for (const auto& entry : fs::directory_iterator(destination)) {
-      if (getParam(params, Parameter::OVERRIDE_DESTINATION)) {
+      if (getParam(params, Parameter::MERGE_DESTINATION)) {
+        break;
+      } else if (getParam(params, Parameter::OVERRIDE_DESTINATION)) {
         try {
           fs::remove_all(entry.path());
         } catch (const fs::filesystem_error& error) {
@@ -157,86 +348,363 @@ void CyberRestore::process() const noexcept {
     std::cout << std::endl << std::string(MAX_STR, '-') << "PROCESS" << std::string(MAX_STR, '-') << std::endl;
   }
 
-  auto source_norm = fs::canonical(fs::absolute(source));
   auto destination_norm = fs::canonical(fs::absolute(destination));
 
-  std::list<fs::path> list_source, list_full_backup;
-  for (const auto& entry : fs::recursive_directory_iterator(source_norm / DIR_NAME)) {
-    if (fs::is_directory(entry.path())) {
-      list_source.push_front(entry.path());
-    } else {
-      list_source.push_back(entry.path());
-    }
+  // A chained restore reads its entries straight out of the manifest, one batch at a time, from first up to last.
+  // Backups without such a manifest are merged in memory and then go through the same batches.
+  auto scan_timer = stats.time(CyberStats::Phase::SCAN);
+  std::vector<CyberEntry> merged;
+  size_t first = 0, last = 0;
+  std::tie(first, last) = selectEntries(layers, source_manifest, chained, deleted, merged);
+  scan_timer.stop();
+
+  if (!selected.empty()) {
+    std::error_code code;
+    fs::create_directories(destination_norm / fs::path(selected).parent_path(), code);
   }
-  for (const auto& entry : fs::recursive_directory_iterator(full_backup_norm / DIR_NAME)) {
-    if (fs::is_directory(entry.path())) {
-      list_full_backup.push_front(entry.path());
-    } else {
-      list_full_backup.push_back(entry.path());
+
+  auto entry_at = [&](size_t ind) { return chained ? source_manifest.entry(ind) : merged[ind]; };
+
+  // A link whose first path lies outside of the selection takes its data over, the rest of its group is linked to it.
+  // Promoted maps the index of such a first path to the index and path of the link standing in for it.
+  std::map<size_t, std::pair<size_t, std::string>> promoted;
+  auto take_over = [&](CyberEntry& entry, size_t leader) {
+    const auto& record = source_manifest.record(leader);
+    entry.storage = static_cast<CyberEntry::Storage>(record.storage);
+    entry.origin = record.origin;
+    entry.hash = record.hash;
+    entry.link.clear();
+  };
+  auto leader_of = [&](size_t ind) {
+    auto leader = static_cast<size_t>(source_manifest.record(ind).link) - 1;
+    auto it = promoted.find(leader);
+    return it == promoted.end() ? leader : it->second.first;
+  };
+
+  // Merging replaces whatever is in the way of an entry, only folders already in place are kept as they are.
+  // What cannot be removed fails that one entry, false then, instead of the whole run.
+  CyberLog success, errors;
+  bool merging = getParam(params, Parameter::MERGE_DESTINATION);
+  auto clear_target = [&](const fs::path& entry, const fs::path& target, const CyberEntry& record) {
+    if (!merging) {
+      return true;
     }
-  }
+    std::error_code code;
+    auto status = fs::symlink_status(target, code);
+    if (code || !fs::exists(status) || (record.isDirectory() && fs::is_directory(status))) {
+      return true;
+    }
+    fs::remove_all(target, code);
+    if (!code) {
+      return true;
+    }
+    auto what = describeFSError(fs::filesystem_error("remove", target, code));
+    abort(code.value(), what, enableParams(params, Parameter::IGNORE_ERRORS));
+    errors.add(entry.native(), what);
+    stats.record(record, false, 0);
+    return false;
+  };
 
-  std::vector<std::pair<fs::path, fs::path>> success, errors;
-  for (const auto& entry : list_full_backup) {
-    auto relative_path =
-        entry.string().substr(full_backup_norm.string().size() + std::strlen(DIR_NAME) + 2, entry.string().size());
-    auto target_path = destination_norm / relative_path;
-    auto source_path = source_norm / DIR_NAME / relative_path;
-    auto full_backup_path = full_backup_norm / DIR_NAME / relative_path;
+  // One batch: its entries, their manifest indices and, for links standing in for their group, where the data is.
+  std::vector<CyberEntry> entries;
+  std::vector<size_t> indices;
+  std::map<size_t, std::string> sources;
+  auto stored_path = [&](size_t ind) -> const std::string& {
+    auto it = sources.find(ind);
+    return it == sources.end() ? entries[ind].path : it->second;
+  };
 
-    if (fs::is_symlink(source_path) || fs::exists(source_path) || to_remove.count(full_backup_path) > 0) {
-      continue;
+  auto restore_entry = [&](size_t ind, std::vector<size_t>& entry_copied, bool prepared = false, uint64_t shared = 0) {
+    auto started = CyberStats::now();
+    const auto& record = entries[ind];
+    auto entry = layers[record.origin] / DIR_NAME / stored_path(ind);
+    auto target_path = destination_norm / record.path;
+    if (!prepared && !clear_target(entry, target_path, record)) {
+      return;
     }
 
-    if (fs::is_directory(entry)) {
-      executeCopy(static_cast<bool (*)(const fs::path&)>(fs::create_directories), success, errors, entry, target_path,
-                  destination, true, target_path);
+    // Metadata is applied as part of each copy, only directory modes and times wait until their contents are written.
+    bool copied = false;
+    if (record.isDirectory()) {
+      copied = executeCopy(
+          [&record](const fs::path& to) {
+            fs::create_directories(to);
+            CyberFile::setOwner(to, record);
+          },
+          success, errors, entry, target_path, destination, true, target_path);
+    } else if (record.isFile() && record.storage == CyberEntry::Storage::CHUNKED) {
+      copied = executeCopy([this, &record](const fs::path& from, const fs::path& to) { chunks.restoreFile(from, to, &record); },
+                           success, errors, entry, target_path, destination, true, entry, target_path);
+    } else if (record.isFile() && record.storage == CyberEntry::Storage::COMPRESSED) {
+      copied = executeCopy(
+          [this, &record](const fs::path& from, const fs::path& to) { compressor.decompressFile(from, to, &record); },
+          success, errors, entry, target_path, destination, true, entry, target_path);
+    } else if (record.isFile() && record.storage == CyberEntry::Storage::DELTA) {
+      // The basis lies under the same path in the backup the delta names, one of the origins of the manifest.
+      copied = executeCopy(
+          [&](const fs::path& from, const fs::path& to) {
+            auto basis = source_norm.parent_path() / CyberDelta::basisOf(from) / DIR_NAME / stored_path(ind);
+            delta.decodeFile(from, basis, to, &record);
+          },
+          success, errors, entry, target_path, destination, true, entry, target_path);
+    } else if (record.isFile()) {
+      copied = executeCopy(
+          [this, &record, prepared](const fs::path& from, const fs::path& to) {
+            if (prepared) {
+              CyberFile::setStat(to, record);
+            } else {
+              copier.copyFile(from, to, &record);
+            }
+          },
+          success, errors, entry, target_path, destination, true, entry, target_path);
     } else {
-      executeCopy(static_cast<void (*)(const fs::path&, const fs::path&, fs::copy_options)>(fs::copy), success, errors, entry,
-                  target_path, destination, true, entry, target_path, fs::copy_options::copy_symlinks);
+      copied = executeCopy(
+          [&record](const fs::path& from, const fs::path& to) {
+            fs::copy(from, to, fs::copy_options::copy_symlinks);
+            if (!record.isSymlink()) {
+              CyberFile::setStat(to, record);
+            }
+          },
+          success, errors, entry, target_path, destination, true, entry, target_path);
     }
-  }
 
-  for (const auto& entry : list_source) {
-    auto relative_path = entry.string().substr(source_norm.string().size() + std::strlen(DIR_NAME) + 2, entry.string().size());
-    auto target_path = destination_norm / relative_path;
+    if (copied) {
+      entry_copied.push_back(ind);
+    }
+    stats.record(record, copied, CyberStats::now() - started + shared);
+  };
 
-    if (fs::is_directory(entry)) {
-      executeCopy(static_cast<bool (*)(const fs::path&)>(fs::create_directories), success, errors, entry, target_path,
-                  destination, true, target_path);
-    } else {
-      executeCopy(static_cast<void (*)(const fs::path&, const fs::path&, fs::copy_options)>(fs::copy), success, errors, entry,
-                  target_path, destination, true, entry, target_path, fs::copy_options::copy_symlinks);
+  auto unpack_entry = [&](const CyberEntry& record, const fs::path& entry, const unsigned char* data, size_t size) {
+    auto started = CyberStats::now();
+    auto target_path = destination_norm / record.path;
+    if (!clear_target(entry, target_path, record)) {
+      return false;
+    }
+
+    bool copied = executeCopy(
+        [&record, data, size](const fs::path& to) {
+          auto file = CyberFile::open(to, O_WRONLY | O_CREAT | O_EXCL);
+          file.write(data, size);
+          file.setStat(record);
+        },
+        success, errors, entry, target_path, destination, true, target_path);
+    stats.record(record, copied, CyberStats::now() - started);
+    return copied;
+  };
+
+  // Kept for the whole run: restored folders, whose times go last, links, which wait for every first path including
+  // packed ones, packed files still to come and whatever failed, as manifest indices.
+  std::vector<size_t> folders, links, pending;
+  std::unordered_set<size_t> failed;
+  std::vector<char> packed_layers(layers.size(), 0);
+
+  auto copy_timer = stats.time(CyberStats::Phase::COPY);
+  CyberPool pool(jobs, &fatal);
+  std::vector<std::vector<size_t>> pool_copied(pool.size());
+  for (size_t start = first; start < last; start += BATCH) {
+    entries.clear();
+    indices.clear();
+    sources.clear();
+    for (size_t ind = start; ind < std::min(last, start + BATCH); ++ind) {
+      entries.push_back(entry_at(ind));
+      indices.push_back(ind);
+      auto leader = chained ? static_cast<size_t>(source_manifest.record(ind).link) : 0;
+      if (leader == 0 || leader - 1 >= first) {
+        continue;
+      }
+      auto& entry = entries.back();
+      auto [it, inserted] = promoted.try_emplace(leader - 1, ind, entry.path);
+      if (inserted) {
+        sources.emplace(entries.size() - 1, entry.link);
+        take_over(entry, leader - 1);
+      } else {
+        entry.link = it->second.second;
+      }
+    }
+
+    // Directories are created up front on this thread, so every file task finds its parent in place.
+    std::vector<size_t> copied, files;
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      const auto& record = entries[ind];
+      if (record.isDirectory()) {
+        restore_entry(ind, copied);
+      } else if (!record.link.empty()) {
+        links.push_back(indices[ind]);
+      } else if (record.isFile() && record.storage == CyberEntry::Storage::PACKED) {
+        // Packed files are written while their segments are read front to back, one task per segment.
+        packed_layers[record.origin] = 1;
+        pending.push_back(indices[ind]);
+      } else {
+        files.push_back(ind);
+      }
+    }
+    for (const auto& ind : copied) {
+      folders.push_back(indices[ind]);
+    }
+
+    // Small plain copies go out in batches through one ring; whatever the ring could not copy takes the usual path.
+    std::vector<size_t> batch;
+    auto submit_batch = [&] {
+      pool.submit([&, batch](size_t worker) mutable {
+        std::vector<CyberCopy::Job> jobs;
+        jobs.reserve(batch.size());
+        std::erase_if(batch, [&](size_t ind) {
+          const auto& record = entries[ind];
+          auto from = layers[record.origin] / DIR_NAME / stored_path(ind);
+          if (!clear_target(from, destination_norm / record.path, record)) {
+            return true;
+          }
+          jobs.push_back({std::move(from), destination_norm / record.path, record.size, record.mode});
+          return false;
+        });
+        if (batch.empty()) {
+          return;
+        }
+
+        auto started = CyberStats::now();
+        bool ringed = copier.copyFiles(jobs);
+        auto shared = (CyberStats::now() - started) / batch.size();
+        for (size_t pos = 0; pos < batch.size(); ++pos) {
+          restore_entry(batch[pos], pool_copied[worker], ringed && jobs[pos].result == 0, shared);
+        }
+      });
+      batch.clear();
+    };
+
+    for (const auto& ind : files) {
+      const auto& record = entries[ind];
+      if (record.isFile() && record.storage == CyberEntry::Storage::PLAIN && record.size <= CyberCopy::RING_MAX) {
+        batch.push_back(ind);
+        if (batch.size() == CyberCopy::RING_BATCH) {
+          submit_batch();
+        }
+        continue;
+      }
+      pool.submit([&, ind](size_t worker) { restore_entry(ind, pool_copied[worker]); });
+    }
+    if (!batch.empty()) {
+      submit_batch();
+    }
+    pool.wait();
+    raiseFailure();
+    mergeResults(copied, pool_copied);
+
+    std::vector<char> done(entries.size(), 0);
+    for (const auto& ind : copied) {
+      done[ind] = 1;
+    }
+    for (const auto& ind : files) {
+      if (done[ind] == 0) {
+        failed.insert(indices[ind]);
+      }
     }
   }
 
-  std::vector<size_t> err_stat;
-  for (size_t ind = 0; ind < success.size(); ++ind) {
-    if (!fs::is_symlink(success[ind].first)) {
-      auto result = setStat(success[ind].first, success[ind].second, destination);
-      if (!result.empty()) {
-        success[ind].second = result;
-        err_stat.push_back(ind);
+  // Segments name their files by path, which the manifest maps back to its records.
+  if (!pending.empty() && chained) {
+    std::vector<std::vector<size_t>> pool_unpacked(pool.size());
+    for (size_t origin = 0; origin < layers.size(); ++origin) {
+      if (packed_layers[origin] == 0) {
+        continue;
+      }
+      for (auto& segment : CyberPacker::listSegments(layers[origin] / PACK_NAME)) {
+        pool.submit([&, origin, segment = std::move(segment)](size_t worker) {
+          try {
+            packer.readSegment(segment, [&](const CyberPacker::Item& item, std::string_view name, const unsigned char* data) {
+              auto ind = source_manifest.find(name);
+              CyberEntry record;
+              if (auto it = promoted.find(ind); it != promoted.end()) {
+                record = source_manifest.entry(it->second.first);
+                take_over(record, ind);
+                ind = it->second.first;
+              } else if (ind >= first && ind < last) {
+                record = source_manifest.entry(ind);
+              } else {
+                return;
+              }
+              if (record.origin != origin || record.storage != CyberEntry::Storage::PACKED) {
+                return;
+              }
+              if (unpack_entry(record, layers[origin] / PACK_NAME / name, data, item.size)) {
+                pool_unpacked[worker].push_back(ind);
+              }
+            });
+          } catch (const fs::filesystem_error& error) {
+            errors.add(segment.native(), reportFSError(error, destination));
+          }
+        });
       }
     }
+    pool.wait();
+    raiseFailure();
+
+    std::vector<size_t> unpacked;
+    mergeResults(unpacked, pool_unpacked);
+    std::sort(unpacked.begin(), unpacked.end());
+    std::vector<size_t> missing;
+    std::set_difference(pending.begin(), pending.end(), unpacked.begin(), unpacked.end(), std::back_inserter(missing));
+    pending.swap(missing);
+  }
+  for (const auto& ind : pending) {
+    auto path = chained ? std::string(source_manifest.name(ind)) : merged[ind].path;
+    auto error = fs::filesystem_error("unpack", layers[entry_at(ind).origin] / PACK_NAME, path,
+                                      std::make_error_code(std::errc::no_such_file_or_directory));
+    errors.add(path, processFSError(error, params, destination));
+    failed.insert(ind);
+  }
+
+  // Further hardlinks share the inode, and with it the metadata, of their first path restored above.
+  size_t linked = 0;
+  for (const auto& ind : links) {
+    auto started = CyberStats::now();
+    auto record = entry_at(ind);
+    auto leader = chained ? leader_of(ind) : last;
+    auto leader_path = chained ? std::string(source_manifest.name(leader)) : record.link;
+    auto target_path = destination_norm / record.path;
+    if (!clear_target(layers[record.origin] / DIR_NAME / record.path, target_path, record)) {
+      continue;
+    }
+
+    bool copied_link = executeCopy(
+        [&](const fs::path& to) {
+          if (!chained || failed.contains(leader)) {
+            throw fs::filesystem_error("link", destination_norm / leader_path, to,
+                                       std::make_error_code(std::errc::no_such_file_or_directory));
+          }
+          fs::create_hard_link(destination_norm / leader_path, to);
+        },
+        success, errors, layers[record.origin] / DIR_NAME / record.path, target_path, destination, true, target_path);
+    linked += copied_link ? 1 : 0;
+    stats.record(record, false, CyberStats::now() - started);
   }
+  copy_timer.stop();
+  stats.finishProgress();
 
-  std::vector<std::pair<fs::path, fs::path>> success_new;
-  size_t pos = 0;
-  for (const auto& ind : err_stat) {
-    while (pos < success.size() && pos < ind) {
-      success_new.push_back(success[pos++]);
+  // Directory modes and times go last and bottom-up, once nothing is created inside them any more.
+  auto metadata_timer = stats.time(CyberStats::Phase::METADATA);
+  for (const auto& ind : std::ranges::reverse_view(folders)) {
+    auto record = entry_at(ind);
+    try {
+      CyberFile::setStat(destination_norm / record.path, record, false);
+    } catch (const fs::filesystem_error& error) {
+      errors.add((layers[record.origin] / DIR_NAME / record.path).native(), processFSError(error, params, destination));
     }
-    errors.push_back(success[pos++]);
   }
-  success_new.insert(success_new.end(), success.begin() + static_cast<int>(pos), success.end());
-  success = success_new;
+  metadata_timer.stop();
+  writeReport("restore", backup_type, errors.size());
 
   if (getParam(params, Parameter::SHOW_ERROR_STAT)) {
     printInfo(errors, "ERROR INFORMATION", "Everything is OK!");
   }
   if (getParam(params, Parameter::SHOW_BACKUP_STAT)) {
     printInfo(success, "RESTORE INFORMATION", "No one entry has been backed up!");
+    std::cout << "\nCopied files (" << copier.describe() << ")" << std::endl;
+    std::cout << "Reassembled files (" << chunks.describe() << ")" << std::endl;
+    std::cout << "Decompressed files (" << compressor.describe() << ")" << std::endl;
+    std::cout << "Rebuilt files (" << delta.describe() << ")" << std::endl;
+    std::cout << "Unpacked files (" << packer.describe() << ")" << std::endl;
+    std::cout << "Linked files (links: " << linked << ")" << std::endl;
+    std::cout << "Phases (" << stats.describe() << ")" << std::endl;
   }
 
   if (!getParam(params, Parameter::SILENT)) {
@@ -244,4 +712,258 @@ void CyberRestore::process() const noexcept {
   }
 }
 
+void CyberRestore::verify(const fs::path& source_norm, const std::vector<fs::path>& layers, const CyberManifest& manifest,
+                          bool chained, const std::vector<std::string>& deleted,
+                          const std::string& backup_type) const noexcept {
+  if (!getParam(params, Parameter::SILENT)) {
+    std::cout << "Verifying " << source << "..." << std::endl;
+  }
+
+  if (getParam(params, Parameter::PROCESS)) {
+    std::cout << std::endl << std::string(MAX_STR, '-') << "PROCESS" << std::string(MAX_STR, '-') << std::endl;
+  }
+
+  auto scan_timer = stats.time(CyberStats::Phase::SCAN);
+  std::vector<CyberEntry> merged;
+  size_t first = 0, last = 0;
+  std::tie(first, last) = selectEntries(layers, manifest, chained, deleted, merged);
+  scan_timer.stop();
+
+  auto entry_at = [&](size_t ind) { return chained ? manifest.entry(ind) : merged[ind]; };
+
+  CyberLog success, errors;
+  std::array<std::atomic<size_t>, static_cast<size_t>(Check::COUNT)> checks{};
+  auto conclude = [&](const CyberEntry& record, const fs::path& stored, Check check, const std::string& detail,
+                      uint64_t started) {
+    ++checks[static_cast<size_t>(check)];
+    bool problem = check > Check::UNHASHED;
+    if (problem) {
+      errors.add(stored.native(), detail);
+    } else {
+      success.add(stored.native(), detail);
+    }
+    if (getParam(params, Parameter::PROCESS) || (problem && !getParam(params, Parameter::SILENT))) {
+      std::lock_guard lock(output_mutex);
+      (problem ? std::cerr : std::cout) << preparePathOutput(stored) << "  -->  " << detail << '\n';
+    }
+    stats.record(record, !problem, CyberStats::now() - started);
+  };
+
+  // A file that cannot be read names its data, or the chunk or basis its data depends on, in the error.
+  auto classify = [](const fs::filesystem_error& error, const fs::path& stored, std::string& detail) {
+    auto where = error.path1() == stored ? std::string() : ", " + preparePathOutput(error.path1());
+    if (error.code() == std::errc::no_such_file_or_directory) {
+      detail = where.empty() ? "missing" : "missing (" + where.substr(2) + ")";
+      return Check::MISSING;
+    }
+    detail = "corrupted (" + error.code().message() + where + ")";
+    return Check::CORRUPTED;
+  };
+  auto compare = [](const CyberEntry& record, uint64_t size, const CyberHash& state, std::string& detail) {
+    if (size != record.size) {
+      detail = std::string(size < record.size ? "truncated" : "size mismatch") + " (" + std::to_string(size) + " of " +
+               std::to_string(record.size) + " bytes)";
+      return size < record.size ? Check::TRUNCATED : Check::MISMATCHED;
+    }
+    if (record.hash == 0) {
+      detail = "readable, no checksum";
+      return Check::UNHASHED;
+    }
+    if (state.value() != record.hash) {
+      detail = "checksum mismatch";
+      return Check::MISMATCHED;
+    }
+    detail = "verified";
+    return Check::VERIFIED;
+  };
+
+  // Every stage streams the content back in order. It is hashed on the way, nothing is written.
+  auto verify_file = [&](const CyberEntry& record, const std::string& path) {
+    auto started = CyberStats::now();
+    auto stored = layers[record.origin] / DIR_NAME / path;
+    CyberHash state;
+    auto sink = [this, &state](const unsigned char* data, size_t size) {
+      scheduler.take(size);
+      state.update(data, size);
+    };
+    // The bytes are paid for as they stream in, so a large file does not hold up the others.
+    auto slot = scheduler.admit(1, record.size, true);
+
+    std::string detail;
+    Check check = Check::VERIFIED;
+    try {
+      uint64_t size = 0;
+      if (record.storage == CyberEntry::Storage::CHUNKED) {
+        size = chunks.readFile(stored, sink);
+      } else if (record.storage == CyberEntry::Storage::COMPRESSED) {
+        size = compressor.readFile(stored, sink);
+      } else if (record.storage == CyberEntry::Storage::DELTA) {
+        auto basis = source_norm.parent_path() / CyberDelta::basisOf(stored) / DIR_NAME / path;
+        size = delta.readFile(stored, basis, sink);
+      } else {
+        size = readPlain(stored, VERIFY_BLOCK, sink);
+      }
+      check = compare(record, size, state, detail);
+    } catch (const fs::filesystem_error& error) {
+      check = classify(error, stored, detail);
+    }
+    conclude(record, stored, check, detail, started);
+  };
+
+  // Folders only carry metadata, which restore takes from the manifest. Anything else has to be in place as it was.
+  auto verify_other = [&](const CyberEntry& record) {
+    auto started = CyberStats::now();
+    auto stored = layers[record.origin] / DIR_NAME / record.path;
+    std::string detail = "verified";
+    Check check = Check::VERIFIED;
+    if (!record.isDirectory()) {
+      std::error_code code;
+      auto status = fs::symlink_status(stored, code);
+      if (code || !fs::exists(status)) {
+        check = Check::MISSING;
+        detail = "missing";
+      } else if (record.isSymlink()) {
+        auto target = fs::read_symlink(stored, code);
+        if (code || !fs::is_symlink(status) || target.native().size() != record.size) {
+          check = Check::MISMATCHED;
+          detail = "symbolic link mismatch";
+        }
+      }
+    }
+    conclude(record, stored, check, detail, started);
+  };
+
+  // Links share the data of their first path, which is read once. A first path outside of the selection is read
+  // in their place.
+  std::vector<size_t> pending, outside;
+  std::vector<char> packed_layers(layers.size(), 0);
+  size_t linked = 0;
+
+  auto copy_timer = stats.time(CyberStats::Phase::COPY);
+  CyberPool pool(jobs);
+  std::vector<CyberEntry> entries;
+  for (size_t start = first; start < last; start += BATCH) {
+    entries.clear();
+    for (size_t ind = start; ind < std::min(last, start + BATCH); ++ind) {
+      entries.push_back(entry_at(ind));
+    }
+
+    for (size_t ind = 0; ind < entries.size(); ++ind) {
+      const auto& record = entries[ind];
+      if (!record.link.empty()) {
+        auto leader = chained ? static_cast<size_t>(manifest.record(start + ind).link) - 1 : last;
+        if (leader < first) {
+          outside.push_back(leader);
+        }
+        ++linked;
+        stats.record(record, false, 0);
+      } else if (record.isFile() && record.storage == CyberEntry::Storage::PACKED) {
+        packed_layers[record.origin] = 1;
+        pending.push_back(start + ind);
+      } else if (record.isFile()) {
+        pool.submit([&, ind](size_t) { verify_file(entries[ind], entries[ind].path); });
+      } else {
+        verify_other(record);
+      }
+    }
+    pool.wait();
+  }
+
+  std::sort(outside.begin(), outside.end());
+  outside.erase(std::unique(outside.begin(), outside.end()), outside.end());
+  for (const auto& ind : outside) {
+    auto record = manifest.entry(ind);
+    if (record.storage == CyberEntry::Storage::PACKED) {
+      packed_layers[record.origin] = 1;
+      pending.push_back(ind);
+    } else {
+      pool.submit([&, record = std::move(record)](size_t) { verify_file(record, record.path); });
+    }
+  }
+  pool.wait();
+  std::sort(pending.begin(), pending.end());
+
+  // Packed files are checked while their segments are read front to back, one task per segment.
+  std::vector<std::vector<size_t>> pool_seen(pool.size());
+  if (!pending.empty() && chained) {
+    for (size_t origin = 0; origin < layers.size(); ++origin) {
+      if (packed_layers[origin] == 0) {
+        continue;
+      }
+      for (auto& segment : CyberPacker::listSegments(layers[origin] / PACK_NAME)) {
+        pool.submit([&, origin, segment = std::move(segment)](size_t worker) {
+          try {
+            packer.readSegment(segment, [&](const CyberPacker::Item& item, std::string_view name, const unsigned char* data) {
+              auto ind = manifest.find(name);
+              if (!std::binary_search(pending.begin(), pending.end(), ind)) {
+                return;
+              }
+              auto record = manifest.entry(ind);
+              if (record.origin != origin || record.storage != CyberEntry::Storage::PACKED) {
+                return;
+              }
+              auto started = CyberStats::now();
+              auto slot = scheduler.admit(1, item.size);
+              CyberHash state;
+              state.update(data, item.size);
+              std::string detail;
+              auto check = compare(record, item.size, state, detail);
+              conclude(record, layers[origin] / PACK_NAME / name, check, detail, started);
+              pool_seen[worker].push_back(ind);
+            });
+          } catch (const fs::filesystem_error& error) {
+            std::string detail;
+            ++checks[static_cast<size_t>(classify(error, segment, detail))];
+            errors.add(segment.native(), detail);
+            if (!getParam(params, Parameter::SILENT)) {
+              std::lock_guard lock(output_mutex);
+              std::cerr << preparePathOutput(segment) << "  -->  " << detail << '\n';
+            }
+          }
+        });
+      }
+    }
+    pool.wait();
+  }
+
+  std::vector<size_t> seen, missing;
+  mergeResults(seen, pool_seen);
+  std::sort(seen.begin(), seen.end());
+  std::set_difference(pending.begin(), pending.end(), seen.begin(), seen.end(), std::back_inserter(missing));
+  for (const auto& ind : missing) {
+    auto record = entry_at(ind);
+    conclude(record, layers[record.origin] / PACK_NAME / record.path, Check::MISSING, "missing", CyberStats::now());
+  }
+  copy_timer.stop();
+  stats.finishProgress();
+
+  size_t problems = errors.size();
+  writeReport("verify", backup_type, problems);
+
+  if (getParam(params, Parameter::SHOW_ERROR_STAT)) {
+    printInfo(errors, "VERIFICATION ERRORS", "Everything is OK!");
+  }
+  if (getParam(params, Parameter::SHOW_BACKUP_STAT)) {
+    printInfo(success, "VERIFICATION INFORMATION", "No one entry has been verified!");
+    std::cout << "\nUnpacked files (" << packer.describe() << ")" << std::endl;
+    std::cout << "Linked files (links: " << linked << ")" << std::endl;
+    std::cout << "Scheduler (" << scheduler.describe() << ")" << std::endl;
+    std::cout << "Phases (" << stats.describe() << ")" << std::endl;
+  }
+
+  auto count = [&checks](Check check) { return std::to_string(checks[static_cast<size_t>(check)].load()); };
+  if (!getParam(params, Parameter::SILENT)) {
+    std::cout << "\nVerified: " << count(Check::VERIFIED) << ", without checksum: " << count(Check::UNHASHED)
+              << ", missing: " << count(Check::MISSING) << ", truncated: " << count(Check::TRUNCATED)
+              << ", mismatched: " << count(Check::MISMATCHED) << ", corrupted: " << count(Check::CORRUPTED) << std::endl;
+  }
+  if (problems != 0) {
+    abort(static_cast<int>(std::errc::io_error), "\n--> Verification failed!",
+          nullifyParams(params, Parameter::REMOVE_INSIDE_ONLY));
+  }
+  if (!getParam(params, Parameter::SILENT)) {
+    std::cout << "\n--> Verify operation completed!" << std::endl;
+  }
+}
+
 }  // namespace nt
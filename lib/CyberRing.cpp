@@ -0,0 +1,159 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 17 October 2026, 5:40 PM
+ *  File    : CyberRing.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberRing.hpp"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+namespace nt {
+
+CyberRing::CyberRing(unsigned entries, unsigned files) noexcept {
+  io_uring_params params{};
+  fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (fd < 0) {
+    fd = -1;
+    return;
+  }
+
+  sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+  }
+
+  sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) {
+    sq_ring = nullptr;
+    release();
+    return;
+  }
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    cq_ring = sq_ring;
+  } else {
+    cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) {
+      cq_ring = nullptr;
+      release();
+      return;
+    }
+  }
+
+  sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes_map = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes_map == MAP_FAILED) {
+    release();
+    return;
+  }
+  sqes = static_cast<io_uring_sqe*>(sqes_map);
+
+  auto* sq = static_cast<char*>(sq_ring);
+  sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_entries = params.sq_entries;
+
+  auto* cq = static_cast<char*>(cq_ring);
+  cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+
+  // Slots set to -1 stay empty until an openat with a file_index fills them.
+  std::vector<int> table(files, -1);
+  if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES, table.data(), files) < 0) {
+    release();
+  }
+}
+
+CyberRing::~CyberRing() {
+  release();
+}
+
+void CyberRing::release() noexcept {
+  if (sqes != nullptr) {
+    munmap(sqes, sqes_size);
+    sqes = nullptr;
+  }
+  if (cq_ring != nullptr && cq_ring != sq_ring) {
+    munmap(cq_ring, cq_ring_size);
+  }
+  cq_ring = nullptr;
+  if (sq_ring != nullptr) {
+    munmap(sq_ring, sq_ring_size);
+    sq_ring = nullptr;
+  }
+  if (fd != -1) {
+    close(fd);
+    fd = -1;
+  }
+}
+
+bool CyberRing::isOpen() const noexcept {
+  return fd != -1;
+}
+
+unsigned CyberRing::capacity() const noexcept {
+  return sq_entries;
+}
+
+io_uring_sqe* CyberRing::prepare() noexcept {
+  unsigned tail = *sq_tail + prepared;
+  if (tail - std::atomic_ref(*sq_head).load(std::memory_order_acquire) >= sq_entries) {
+    return nullptr;
+  }
+
+  unsigned ind = tail & sq_mask;
+  sq_array[ind] = ind;
+  ++prepared;
+  auto* sqe = &sqes[ind];
+  std::memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+int CyberRing::submit(unsigned wait) noexcept {
+  std::atomic_ref(*sq_tail).store(*sq_tail + prepared, std::memory_order_release);
+  prepared = 0;
+
+  // The kernel takes at most what is still queued, so a retry after an interruption never submits twice.
+  while (true) {
+    unsigned count = *sq_tail - std::atomic_ref(*sq_head).load(std::memory_order_acquire);
+    auto result = syscall(__NR_io_uring_enter, fd, count, wait, wait != 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+    if (result >= 0) {
+      return static_cast<int>(result);
+    }
+    if (errno != EINTR) {
+      return -errno;
+    }
+  }
+}
+
+unsigned CyberRing::discard() noexcept {
+  unsigned head = std::atomic_ref(*sq_head).load(std::memory_order_acquire);
+  unsigned dropped = *sq_tail + prepared - head;
+  std::atomic_ref(*sq_tail).store(head, std::memory_order_release);
+  prepared = 0;
+  return dropped;
+}
+
+unsigned CyberRing::loadTail() const noexcept {
+  return std::atomic_ref(*cq_tail).load(std::memory_order_acquire);
+}
+
+void CyberRing::storeHead(unsigned value) noexcept {
+  std::atomic_ref(*cq_head).store(value, std::memory_order_release);
+}
+
+}  // namespace nt
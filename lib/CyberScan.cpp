@@ -0,0 +1,137 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 16 October 2026, 11:40 AM
+ *  File    : CyberScan.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberScan.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace nt {
+
+namespace {
+
+constexpr unsigned STATX_MASK = STATX_TYPE | STATX_MODE | STATX_NLINK | STATX_UID | STATX_GID | STATX_ATIME | STATX_MTIME |
+                                STATX_INO | STATX_SIZE;
+
+int64_t toNanoseconds(const struct statx_timestamp& time) {
+  return time.tv_sec * 1'000'000'000 + time.tv_nsec;
+}
+
+CyberEntry::Type toType(uint16_t mode) {
+  switch (mode & S_IFMT) {
+    case S_IFREG:
+      return CyberEntry::Type::FILE;
+    case S_IFDIR:
+      return CyberEntry::Type::DIRECTORY;
+    case S_IFLNK:
+      return CyberEntry::Type::SYMLINK;
+    default:
+      return CyberEntry::Type::OTHER;
+  }
+}
+
+}  // namespace
+
+bool CyberEntry::isDirectory() const noexcept {
+  return type == Type::DIRECTORY;
+}
+
+bool CyberEntry::isSymlink() const noexcept {
+  return type == Type::SYMLINK;
+}
+
+bool CyberEntry::isFile() const noexcept {
+  return type == Type::FILE;
+}
+
+bool CyberScan::stat(const fs::path& path, CyberEntry& entry) noexcept {
+  struct statx result{};
+  if (statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, STATX_MASK, &result) != 0) {
+    entry.type = CyberEntry::Type::NONE;
+    return false;
+  }
+
+  entry.type = toType(result.stx_mode);
+  entry.mode = result.stx_mode;
+  entry.uid = result.stx_uid;
+  entry.gid = result.stx_gid;
+  entry.nlink = result.stx_nlink;
+  entry.size = result.stx_size;
+  entry.device = makedev(result.stx_dev_major, result.stx_dev_minor);
+  entry.inode = result.stx_ino;
+  entry.atime = toNanoseconds(result.stx_atime);
+  entry.mtime = toNanoseconds(result.stx_mtime);
+  return true;
+}
+
+void CyberScan::walk(const fs::path& root, const Visitor& visit, const Failure& failed) {
+  struct Folder {
+    std::string prefix;
+    std::vector<std::string> names;
+    size_t next = 0;
+  };
+
+  auto list = [&root](const std::string& path, std::vector<std::string>& names) {
+    auto folder = path.empty() ? root : root / path;
+    DIR* dir = opendir(folder.c_str());
+    if (dir == nullptr) {
+      return errno;
+    }
+    while (const auto* item = readdir(dir)) {
+      if (std::strcmp(item->d_name, ".") != 0 && std::strcmp(item->d_name, "..") != 0) {
+        names.emplace_back(item->d_name);
+      }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return 0;
+  };
+
+  std::vector<Folder> stack(1);
+  if (auto code = list({}, stack.back().names); code != 0) {
+    throw fs::filesystem_error("scan", root, std::error_code(code, std::generic_category()));
+  }
+
+  while (!stack.empty()) {
+    auto& folder = stack.back();
+    if (folder.next == folder.names.size()) {
+      stack.pop_back();
+      continue;
+    }
+
+    CyberEntry entry;
+    entry.path = folder.prefix + folder.names[folder.next++];
+    // An entry removed between readdir and statx is simply not part of the backup.
+    if (!stat(root / entry.path, entry)) {
+      continue;
+    }
+
+    std::string path = entry.isDirectory() ? entry.path : std::string();
+    visit(std::move(entry));
+    if (!path.empty()) {
+      Folder child{path + '/', {}, 0};
+      if (auto code = list(path, child.names); code == 0) {
+        stack.push_back(std::move(child));
+      } else if (failed) {
+        failed(fs::filesystem_error("scan", root / path, std::error_code(code, std::generic_category())));
+      }
+    }
+  }
+}
+
+std::vector<CyberEntry> CyberScan::scan(const fs::path& root) {
+  std::vector<CyberEntry> entries;
+  walk(root, [&entries](CyberEntry&& entry) { entries.push_back(std::move(entry)); });
+  return entries;
+}
+
+}  // namespace nt
@@ -0,0 +1,231 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 9:15 PM
+ *  File    : CyberScheduler.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberScheduler.hpp"
+
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <utility>
+
+#include "../include/CyberStats.hpp"
+
+namespace nt {
+
+namespace {
+
+// From linux/ioprio.h, which older kernel headers lack.
+constexpr int IOPRIO_WHO_PROCESS = 1;
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+constexpr int IOPRIO_CLASS_BE = 2;
+constexpr int IOPRIO_CLASS_IDLE = 3;
+
+}  // namespace
+
+CyberScheduler::Slot::Slot(const CyberScheduler* scheduler, uint64_t bytes) noexcept
+    : scheduler(scheduler), bytes(bytes), start(CyberStats::now()) {}
+
+CyberScheduler::Slot::Slot(Slot&& other) noexcept
+    : scheduler(std::exchange(other.scheduler, nullptr)), bytes(other.bytes), start(other.start) {}
+
+CyberScheduler::Slot& CyberScheduler::Slot::operator=(Slot&& other) noexcept {
+  if (this != &other) {
+    if (scheduler != nullptr) {
+      scheduler->release(bytes, CyberStats::now() - start);
+    }
+    scheduler = std::exchange(other.scheduler, nullptr);
+    bytes = other.bytes;
+    start = other.start;
+  }
+  return *this;
+}
+
+CyberScheduler::Slot::~Slot() {
+  if (scheduler != nullptr) {
+    scheduler->release(bytes, CyberStats::now() - start);
+  }
+}
+
+void CyberScheduler::setBytesRate(uint64_t value) noexcept {
+  bytes_limit.setRate(value);
+}
+
+void CyberScheduler::setFilesRate(uint64_t value) noexcept {
+  files_limit.setRate(value);
+}
+
+void CyberScheduler::setPriority(Priority value, int value_level) noexcept {
+  priority = value;
+  level = value_level;
+}
+
+void CyberScheduler::setLatency(uint64_t value) noexcept {
+  latency = value;
+}
+
+bool CyberScheduler::parsePriority(const std::string& value, Priority& result, int& result_level) {
+  if (value == "idle") {
+    result = Priority::IDLE;
+    result_level = 0;
+    return true;
+  }
+  if (value == "best-effort") {
+    result = Priority::BEST_EFFORT;
+    result_level = LOWEST_LEVEL;
+    return true;
+  }
+  if (!value.starts_with("best-effort:")) {
+    return false;
+  }
+  int number = 0;
+  const char* first = value.data() + 12;
+  const char* last = value.data() + value.size();
+  auto [ptr, ec] = std::from_chars(first, last, number);
+  if (ec != std::errc() || ptr != last || number < 0 || number > LOWEST_LEVEL) {
+    return false;
+  }
+  result = Priority::BEST_EFFORT;
+  result_level = number;
+  return true;
+}
+
+void CyberScheduler::start(const fs::path& path, size_t value_jobs) {
+  jobs = std::max<size_t>(value_jobs, 1);
+  limit = jobs;
+  counters.lowest = jobs;
+
+  // Partitions and mapped devices have statistics of their own. File systems without a block device have none.
+  struct stat info{};
+  if (latency != 0 && ::stat(path.c_str(), &info) == 0) {
+    device_stat = "/sys/dev/block/" + std::to_string(major(info.st_dev)) + ":" + std::to_string(minor(info.st_dev)) + "/stat";
+    if (!readDevice(device_reads, device_ticks)) {
+      device_stat.clear();
+    }
+  }
+  next_check = CyberStats::now() + PERIOD;
+
+  if (priority == Priority::DEFAULT) {
+    return;
+  }
+  int io_class = priority == Priority::IDLE ? IOPRIO_CLASS_IDLE : IOPRIO_CLASS_BE;
+  if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, (io_class << IOPRIO_CLASS_SHIFT) | level) == -1) {
+    throw fs::filesystem_error("ioprio", path, std::error_code(errno, std::generic_category()));
+  }
+}
+
+CyberScheduler::Slot CyberScheduler::admit(uint64_t files, uint64_t bytes, bool streamed) const {
+  files_limit.take(files);
+  if (!streamed) {
+    bytes_limit.take(bytes);
+  }
+  ++counters.admitted;
+  if (latency == 0) {
+    return {};
+  }
+
+  std::unique_lock lock(mutex);
+  freed.wait(lock, [this] { return active < limit; });
+  ++active;
+  return {this, bytes};
+}
+
+void CyberScheduler::take(uint64_t bytes) const {
+  bytes_limit.take(bytes);
+}
+
+void CyberScheduler::charge(uint64_t files, uint64_t bytes) const {
+  files_limit.take(files);
+  bytes_limit.take(bytes);
+}
+
+void CyberScheduler::release(uint64_t bytes, uint64_t elapsed) const noexcept {
+  {
+    std::lock_guard lock(mutex);
+    --active;
+  }
+  freed.notify_one();
+
+  if (device_stat.empty() && bytes <= SAMPLE_SIZE) {
+    sampled_time += elapsed;
+    ++sampled;
+  }
+  // One thread per period takes the measurement, the others carry on.
+  auto now = CyberStats::now();
+  auto due = next_check.load(std::memory_order_relaxed);
+  if (now >= due && next_check.compare_exchange_strong(due, now + PERIOD, std::memory_order_relaxed)) {
+    adapt();
+  }
+}
+
+bool CyberScheduler::readDevice(uint64_t& reads, uint64_t& ticks) const noexcept {
+  // Fields 1 and 4 of the block device statistics: reads completed and milliseconds spent reading.
+  std::ifstream input(device_stat);
+  uint64_t merged = 0, sectors = 0;
+  return static_cast<bool>(input >> reads >> merged >> sectors >> ticks);
+}
+
+void CyberScheduler::adapt() const noexcept {
+  uint64_t observed = 0;
+  uint64_t reads = 0, ticks = 0;
+  if (!device_stat.empty() && readDevice(reads, ticks)) {
+    if (reads > device_reads) {
+      observed = (ticks - device_ticks) * 1'000'000 / (reads - device_reads);
+    }
+    device_reads = reads;
+    device_ticks = ticks;
+  } else if (device_stat.empty()) {
+    auto count = sampled.exchange(0);
+    auto time = sampled_time.exchange(0);
+    observed = count != 0 ? time / count : 0;
+  }
+  // A period without reads, all served from the cache, says nothing about the device.
+  if (observed == 0) {
+    return;
+  }
+
+  counters.latency = observed;
+  {
+    std::lock_guard lock(mutex);
+    if (observed > latency && limit > 1) {
+      limit /= 2;
+      ++counters.backoffs;
+      counters.lowest = std::min(counters.lowest.load(), limit);
+    } else if (observed < latency / 2 && limit < jobs) {
+      ++limit;
+    }
+  }
+  freed.notify_all();
+}
+
+const CyberScheduler::Counters& CyberScheduler::getCounters() const noexcept {
+  return counters;
+}
+
+std::string CyberScheduler::describe() const {
+  std::string name = priority == Priority::IDLE          ? "idle"
+                     : priority == Priority::BEST_EFFORT ? "best-effort:" + std::to_string(level)
+                                                         : "default";
+  size_t current = 0;
+  {
+    std::lock_guard lock(mutex);
+    current = limit;
+  }
+  auto waited = (files_limit.getWaited() + bytes_limit.getWaited()) / 1'000'000;
+  return "priority: " + name + ", bytes/s: " + std::to_string(bytes_limit.getRate()) +
+         ", files/s: " + std::to_string(files_limit.getRate()) + ", admitted: " + std::to_string(counters.admitted.load()) +
+         ", waited: " + std::to_string(waited) + " ms, limit: " + std::to_string(current) + "/" + std::to_string(jobs) +
+         ", lowest: " + std::to_string(counters.lowest.load()) + ", backoffs: " + std::to_string(counters.backoffs.load()) +
+         ", latency: " + std::to_string(counters.latency.load() / 1'000) + " us" +
+         (latency != 0 && device_stat.empty() ? " (sampled)" : "");
+}
+
+}  // namespace nt
@@ -0,0 +1,237 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 18 October 2026, 2:20 PM
+ *  File    : CyberStats.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberStats.hpp"
+
+#include <unistd.h>
+
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace nt {
+
+namespace {
+
+double toSeconds(uint64_t nanoseconds) {
+  return static_cast<double>(nanoseconds) / 1e9;
+}
+
+std::string formatBytes(double value) {
+  static constexpr const char* UNITS[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+  size_t unit = 0;
+  while (value >= 1024 && unit + 1 < std::size(UNITS)) {
+    value /= 1024;
+    ++unit;
+  }
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.1f %s", value, UNITS[unit]);
+  return buffer;
+}
+
+std::string escape(const std::string& value) {
+  std::string result;
+  result.reserve(value.size());
+  for (char symbol : value) {
+    if (symbol == '"' || symbol == '\\') {
+      result += '\\';
+      result += symbol;
+    } else if (static_cast<unsigned char>(symbol) < 0x20) {
+      char buffer[8];
+      std::snprintf(buffer, sizeof(buffer), "\\u%04x", symbol);
+      result += buffer;
+    } else {
+      result += symbol;
+    }
+  }
+  return result;
+}
+
+// Bucket ind holds the values below 2^ind, bucket 0 only zero.
+void writeHistogram(std::ostream& out, const std::array<std::atomic<uint64_t>, CyberStats::BUCKETS>& buckets,
+                    const char* bound) {
+  out << "[";
+  bool first = true;
+  for (size_t ind = 0; ind < buckets.size(); ++ind) {
+    auto count = buckets[ind].load(std::memory_order_relaxed);
+    if (count == 0) {
+      continue;
+    }
+    out << (first ? "\n" : ",\n") << "    {\"" << bound << "\": "
+        << (ind == 0 ? 0 : ind < 64 ? (uint64_t{1} << ind) - 1 : UINT64_MAX) << ", \"files\": " << count << "}";
+    first = false;
+  }
+  out << (first ? "]" : "\n  ]");
+}
+
+}  // namespace
+
+CyberStats::Timer::Timer(const CyberStats& stats, Phase phase) noexcept : stats(&stats), phase(phase), start(now()) {}
+
+CyberStats::Timer::~Timer() {
+  stop();
+}
+
+void CyberStats::Timer::stop() noexcept {
+  if (stats != nullptr) {
+    stats->addTime(phase, now() - start);
+    stats = nullptr;
+  }
+}
+
+CyberStats::CyberStats() noexcept : started(now()) {}
+
+uint64_t CyberStats::now() noexcept {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+const char* CyberStats::phaseName(Phase phase) noexcept {
+  switch (phase) {
+    case Phase::SCAN:
+      return "scan";
+    case Phase::COMPARE:
+      return "compare";
+    case Phase::COPY:
+      return "copy";
+    case Phase::METADATA:
+      return "metadata";
+    case Phase::SUMMARY:
+      return "summary";
+    case Phase::DELETION:
+      return "deletion";
+    case Phase::COUNT:
+      break;
+  }
+  return "";
+}
+
+CyberStats::Timer CyberStats::time(Phase phase) const noexcept {
+  return {*this, phase};
+}
+
+void CyberStats::addTime(Phase phase, uint64_t nanoseconds) const noexcept {
+  counters.phases[static_cast<size_t>(phase)].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void CyberStats::setProgress(bool enable) noexcept {
+  progress = enable;
+}
+
+void CyberStats::setTotal(size_t entries, uint64_t bytes) const noexcept {
+  counters.total_entries.store(entries, std::memory_order_relaxed);
+  counters.total_bytes.store(bytes, std::memory_order_relaxed);
+}
+
+void CyberStats::record(const CyberEntry& entry, bool copied, uint64_t nanoseconds) const noexcept {
+  counters.entries.fetch_add(1, std::memory_order_relaxed);
+  if (copied && entry.isFile()) {
+    counters.files.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(entry.size, std::memory_order_relaxed);
+    counters.sizes[std::bit_width(entry.size)].fetch_add(1, std::memory_order_relaxed);
+    counters.latencies[std::bit_width(nanoseconds / 1000)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (!progress) {
+    return;
+  }
+  // Only the worker which moves the deadline forward draws, everybody else just counts.
+  auto moment = now();
+  auto deadline = counters.next_progress.load(std::memory_order_relaxed);
+  if (moment >= deadline &&
+      counters.next_progress.compare_exchange_strong(deadline, moment + PROGRESS_PERIOD, std::memory_order_relaxed)) {
+    drawProgress(moment);
+  }
+}
+
+void CyberStats::finishProgress() const noexcept {
+  if (progress) {
+    drawProgress(now());
+    (void)!::write(STDERR_FILENO, "\n", 1);
+  }
+}
+
+void CyberStats::drawProgress(uint64_t moment) const noexcept {
+  auto done = counters.entries.load(std::memory_order_relaxed);
+  auto total = counters.total_entries.load(std::memory_order_relaxed);
+  auto copied = counters.bytes.load(std::memory_order_relaxed);
+  auto expected = counters.total_bytes.load(std::memory_order_relaxed);
+  auto elapsed = std::max(toSeconds(moment - started), 1e-9);
+  auto rate = static_cast<double>(copied) / elapsed;
+
+  // The ETA follows bytes while there are any left to copy and entries otherwise.
+  double left = 0;
+  if (expected > copied && rate > 0) {
+    left = static_cast<double>(expected - copied) / rate;
+  } else if (total > done && done != 0) {
+    left = static_cast<double>(total - done) * elapsed / static_cast<double>(done);
+  }
+  auto eta = static_cast<unsigned long>(left);
+
+  char line[160];
+  int size = std::snprintf(line, sizeof(line), "\r%zu/%zu entries  %s/%s  %s/s  ETA %02lu:%02lu:%02lu   ", done, total,
+                           formatBytes(static_cast<double>(copied)).c_str(), formatBytes(static_cast<double>(expected)).c_str(),
+                           formatBytes(rate).c_str(), eta / 3600, eta / 60 % 60, eta % 60);
+  if (size > 0) {
+    (void)!::write(STDERR_FILENO, line, std::min(static_cast<size_t>(size), sizeof(line) - 1));
+  }
+}
+
+const CyberStats::Counters& CyberStats::getCounters() const noexcept {
+  return counters;
+}
+
+std::string CyberStats::describe() const {
+  std::string result;
+  for (size_t ind = 0; ind < counters.phases.size(); ++ind) {
+    std::ostringstream value;
+    value << std::fixed << std::setprecision(3) << toSeconds(counters.phases[ind].load(std::memory_order_relaxed));
+    result += (ind == 0 ? "" : ", ") + std::string(phaseName(static_cast<Phase>(ind))) + ": " + value.str() + "s";
+  }
+  return result;
+}
+
+bool CyberStats::writeReport(const fs::path& path, const std::string& tool, const std::string& type, size_t errors) const {
+  auto wall = toSeconds(now() - started);
+  auto seconds = std::max(wall, 1e-9);
+  auto copied_files = counters.files.load(std::memory_order_relaxed);
+  auto copied_bytes = counters.bytes.load(std::memory_order_relaxed);
+
+  std::ofstream out(path, std::ios::out | std::ios::trunc);
+  if (!out.is_open()) {
+    return false;
+  }
+
+  out << std::fixed << std::setprecision(6);
+  out << "{\n"
+      << "  \"tool\": \"" << escape(tool) << "\",\n"
+      << "  \"type\": \"" << escape(type) << "\",\n"
+      << "  \"wall_seconds\": " << wall << ",\n"
+      << "  \"entries\": " << counters.entries.load(std::memory_order_relaxed) << ",\n"
+      << "  \"files\": " << copied_files << ",\n"
+      << "  \"bytes\": " << copied_bytes << ",\n"
+      << "  \"errors\": " << errors << ",\n"
+      << "  \"files_per_second\": " << static_cast<double>(copied_files) / seconds << ",\n"
+      << "  \"mb_per_second\": " << static_cast<double>(copied_bytes) / seconds / (1 << 20) << ",\n"
+      << "  \"phases\": {";
+  for (size_t ind = 0; ind < counters.phases.size(); ++ind) {
+    out << (ind == 0 ? "\n" : ",\n") << "    \"" << phaseName(static_cast<Phase>(ind))
+        << "\": " << toSeconds(counters.phases[ind].load(std::memory_order_relaxed));
+  }
+  out << "\n  },\n  \"size_histogram\": ";
+  writeHistogram(out, counters.sizes, "max_bytes");
+  out << ",\n  \"latency_histogram\": ";
+  writeHistogram(out, counters.latencies, "max_microseconds");
+  out << "\n}\n";
+
+  return static_cast<bool>(out.flush());
+}
+
+}  // namespace nt
@@ -0,0 +1,51 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 8:20 PM
+ *  File    : CyberThrottle.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberThrottle.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "../include/CyberStats.hpp"
+
+namespace nt {
+
+void CyberThrottle::setRate(uint64_t value) noexcept {
+  rate = value;
+}
+
+uint64_t CyberThrottle::getRate() const noexcept {
+  return rate;
+}
+
+void CyberThrottle::take(uint64_t units) const {
+  if (rate == 0) {
+    return;
+  }
+
+  auto cost = static_cast<uint64_t>(static_cast<unsigned __int128>(units) * 1'000'000'000 / rate);
+  auto now = CyberStats::now();
+  auto start = due.load(std::memory_order_relaxed);
+  uint64_t booked = 0;
+  do {
+    // Time left unused is gone, a pause does not buy a long burst afterwards.
+    booked = std::max(start, now) + cost;
+  } while (!due.compare_exchange_weak(start, booked, std::memory_order_relaxed));
+
+  // The caller goes ahead once no more than BURST of its booking is left.
+  if (booked > now + BURST) {
+    waited += booked - now - BURST;
+    std::this_thread::sleep_for(std::chrono::nanoseconds(booked - now - BURST));
+  }
+}
+
+uint64_t CyberThrottle::getWaited() const noexcept {
+  return waited.load();
+}
+
+}  // namespace nt
@@ -0,0 +1,321 @@
+/******************************************\
+ *  Author  : NTheme - All rights reserved
+ *  Created : 19 October 2026, 4:40 PM
+ *  File    : CyberWatch.cpp
+ *  Project : Backup
+\******************************************/
+
+#include "../include/CyberWatch.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/fanotify.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace nt {
+
+namespace {
+
+constexpr uint64_t FANOTIFY_MASK = FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_MODIFY | FAN_ATTRIB | FAN_ONDIR;
+constexpr uint32_t INOTIFY_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB | IN_ONLYDIR |
+                                  IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+constexpr size_t BUFFER = 64 << 10;
+// Resolved folder handles are dropped once there are this many, or as soon as any folder moves.
+constexpr size_t HANDLES_MAX = 1 << 16;
+
+}  // namespace
+
+CyberWatch::CyberWatch(CyberJournal& journal) : journal(journal) {}
+
+CyberWatch::~CyberWatch() {
+  if (fd != -1) {
+    close(fd);
+  }
+  if (mount_fd != -1) {
+    close(mount_fd);
+  }
+}
+
+void CyberWatch::start() {
+  if (!startFanotify()) {
+    startInotify();
+  }
+  // Only what happens from now on is reported, so that is where the journal starts to be complete.
+  journal.reset(CyberJournal::now());
+}
+
+bool CyberWatch::startFanotify() {
+  const auto& root = journal.getRoot();
+  fd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_CLOEXEC | FAN_NONBLOCK, O_RDONLY | O_LARGEFILE);
+  if (fd == -1) {
+    return false;
+  }
+  mount_fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  // The folder handles of events are worth nothing unless they can be opened again, which needs CAP_DAC_READ_SEARCH.
+  std::vector<char> storage(sizeof(file_handle) + MAX_HANDLE_SZ);
+  auto* handle = reinterpret_cast<file_handle*>(storage.data());
+  handle->handle_bytes = MAX_HANDLE_SZ;
+  int mount_id = 0;
+  bool usable = mount_fd != -1 && fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, FANOTIFY_MASK, AT_FDCWD, root.c_str()) == 0 &&
+                name_to_handle_at(AT_FDCWD, root.c_str(), handle, &mount_id, 0) == 0;
+  if (usable) {
+    int probe = open_by_handle_at(mount_fd, handle, O_PATH | O_CLOEXEC);
+    usable = probe != -1;
+    if (usable) {
+      close(probe);
+    }
+  }
+
+  if (!usable) {
+    close(fd);
+    fd = -1;
+    if (mount_fd != -1) {
+      close(mount_fd);
+      mount_fd = -1;
+    }
+    return false;
+  }
+  backend = Backend::FANOTIFY;
+  return true;
+}
+
+void CyberWatch::startInotify() {
+  fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd == -1) {
+    throw fs::filesystem_error("watch", journal.getRoot(), std::error_code(errno, std::generic_category()));
+  }
+  backend = Backend::INOTIFY;
+  watchTree({});
+}
+
+void CyberWatch::watchTree(const std::string& path) {
+  const auto& root = journal.getRoot();
+  // Every folder is watched before it is listed, so whatever turns up in it later is reported. Watching a folder
+  // again returns its old descriptor, which then simply stands for the new path of a moved folder.
+  auto add = [&](const std::string& folder) {
+    auto full = folder.empty() ? root : root / folder;
+    int wd = inotify_add_watch(fd, full.c_str(), INOTIFY_MASK);
+    if (wd != -1) {
+      watches[wd] = folder;
+    } else if (errno == ENOSPC || errno == ENOMEM) {
+      throw fs::filesystem_error("watch", full, std::error_code(errno, std::generic_category()));
+    }
+  };
+
+  add(path);
+  try {
+    CyberScan::walk(path.empty() ? root : root / path, [&](CyberEntry&& entry) {
+      if (entry.isDirectory()) {
+        add(path.empty() ? entry.path : path + '/' + entry.path);
+      }
+    });
+  } catch (const fs::filesystem_error& error) {
+    // A folder gone meanwhile has its removal journaled, only running out of watches is fatal.
+    if (error.code().value() == ENOSPC || error.code().value() == ENOMEM) {
+      throw;
+    }
+  }
+}
+
+void CyberWatch::poll(int timeout) {
+  pollfd item{fd, POLLIN, 0};
+  if (::poll(&item, 1, timeout) <= 0) {
+    return;
+  }
+  if (backend == Backend::FANOTIFY) {
+    readFanotify();
+  } else {
+    readInotify();
+  }
+}
+
+void CyberWatch::readFanotify() {
+  const auto& root = journal.getRoot().native();
+  auto resolve = [&](file_handle* handle, std::string& path) {
+    std::string key(reinterpret_cast<const char*>(handle), sizeof(file_handle) + handle->handle_bytes);
+    if (auto it = handles.find(key); it != handles.end()) {
+      path = it->second;
+      return path.empty() || path.front() != '/';
+    }
+
+    int folder = open_by_handle_at(mount_fd, handle, O_PATH | O_CLOEXEC);
+    if (folder == -1) {
+      return false;
+    }
+    char target[PATH_MAX];
+    auto link = "/proc/self/fd/" + std::to_string(folder);
+    auto size = readlink(link.c_str(), target, sizeof(target));
+    close(folder);
+    if (size <= 0 || static_cast<size_t>(size) == sizeof(target)) {
+      return false;
+    }
+
+    // Folders outside of the root are remembered as such, by their absolute path. Removed ones are not remembered.
+    path.assign(target, size);
+    if (path.ends_with(" (deleted)")) {
+      return false;
+    }
+    if (path == root) {
+      path.clear();
+    } else if (path.starts_with(root) && path[root.size()] == '/') {
+      path.erase(0, root.size() + 1);
+    }
+    if (handles.size() == HANDLES_MAX) {
+      handles.clear();
+    }
+    handles.emplace(std::move(key), path);
+    return path.empty() || path.front() != '/';
+  };
+
+  alignas(fanotify_event_metadata) char buffer[BUFFER];
+  std::string folder;
+  for (;;) {
+    auto length = read(fd, buffer, sizeof(buffer));
+    if (length < 0 && errno == EINTR) {
+      continue;
+    }
+    if (length <= 0) {
+      break;
+    }
+
+    // Events are only aligned to 4 bytes, so their headers and handles are copied out before any field is read.
+    for (ssize_t offset = 0; length - offset >= static_cast<ssize_t>(sizeof(fanotify_event_metadata));) {
+      fanotify_event_metadata meta;
+      std::memcpy(&meta, buffer + offset, sizeof(meta));
+      if (meta.event_len < sizeof(meta) || meta.event_len > static_cast<size_t>(length - offset)) {
+        break;
+      }
+      const char* event = buffer + offset;
+      offset += meta.event_len;
+      ++events;
+      if (meta.fd >= 0) {
+        close(meta.fd);
+      }
+      if ((meta.mask & FAN_Q_OVERFLOW) != 0) {
+        overflow();
+        continue;
+      }
+      auto handle_offset = meta.metadata_len + offsetof(fanotify_event_info_fid, handle);
+      if (meta.event_len < handle_offset + sizeof(file_handle)) {
+        continue;
+      }
+      fanotify_event_info_fid info;
+      std::memcpy(&info, event + meta.metadata_len, sizeof(info));
+      if (info.hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME && info.hdr.info_type != FAN_EVENT_INFO_TYPE_DFID) {
+        continue;
+      }
+      file_handle header;
+      std::memcpy(&header, event + handle_offset, sizeof(header));
+      if (header.handle_bytes > MAX_HANDLE_SZ || meta.event_len < handle_offset + sizeof(file_handle) + header.handle_bytes) {
+        continue;
+      }
+      alignas(file_handle) char stored[sizeof(file_handle) + MAX_HANDLE_SZ];
+      std::memcpy(stored, event + handle_offset, sizeof(file_handle) + header.handle_bytes);
+      auto* handle = reinterpret_cast<file_handle*>(stored);
+
+      std::string_view name;
+      if (info.hdr.info_type == FAN_EVENT_INFO_TYPE_DFID_NAME) {
+        name = event + handle_offset + sizeof(file_handle) + header.handle_bytes;
+      }
+      bool listing = (meta.mask & (FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO)) != 0;
+      bool is_folder = (meta.mask & FAN_ONDIR) != 0;
+      bool resolved = resolve(handle, folder);
+      // Paths below a folder which moved or went away are out of date now.
+      if (is_folder && listing) {
+        handles.clear();
+      }
+      if (resolved) {
+        note(folder, name == "." ? std::string_view() : name, listing, is_folder && (meta.mask & FAN_MOVED_TO) != 0);
+      }
+    }
+  }
+}
+
+void CyberWatch::readInotify() {
+  alignas(inotify_event) char buffer[BUFFER];
+  for (;;) {
+    auto length = read(fd, buffer, sizeof(buffer));
+    if (length < 0 && errno == EINTR) {
+      continue;
+    }
+    if (length <= 0) {
+      break;
+    }
+
+    for (ssize_t offset = 0; offset < length;) {
+      const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+      offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+      ++events;
+      if ((event->mask & IN_Q_OVERFLOW) != 0) {
+        overflow();
+        continue;
+      }
+      if ((event->mask & IN_IGNORED) != 0) {
+        watches.erase(event->wd);
+        continue;
+      }
+      auto it = watches.find(event->wd);
+      if (it == watches.end()) {
+        continue;
+      }
+
+      auto folder = it->second;
+      std::string_view name = event->len != 0 ? std::string_view(event->name) : std::string_view();
+      bool listing = (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) != 0;
+      // A new folder may fill up before its watch is in place, it is journaled as a whole.
+      bool tree = (event->mask & IN_ISDIR) != 0 && (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0;
+      if (tree) {
+        watchTree(folder.empty() ? std::string(name) : folder + '/' + std::string(name));
+      }
+      note(folder, name, listing, tree);
+    }
+  }
+}
+
+void CyberWatch::note(const std::string& folder, std::string_view name, bool listing, bool tree) {
+  auto time = CyberJournal::now();
+  // The root itself is no entry of a backup.
+  if (name.empty()) {
+    if (!folder.empty()) {
+      journal.record(folder, tree, time);
+    }
+    return;
+  }
+  journal.record(folder.empty() ? std::string(name) : folder + '/' + std::string(name), tree, time);
+  if (listing && !folder.empty()) {
+    journal.record(folder, false, time);
+  }
+}
+
+void CyberWatch::overflow() {
+  ++overflows;
+  // Inotify may have missed new folders as well, every folder is watched again before the journal starts over.
+  if (backend == Backend::INOTIFY) {
+    watchTree({});
+  }
+  handles.clear();
+  journal.reset(CyberJournal::now());
+}
+
+CyberWatch::Backend CyberWatch::getBackend() const noexcept {
+  return backend;
+}
+
+size_t CyberWatch::getOverflows() const noexcept {
+  return overflows;
+}
+
+std::string CyberWatch::describe() const {
+  std::string name = backend == Backend::FANOTIFY ? "fanotify" : backend == Backend::INOTIFY ? "inotify" : "none";
+  return "backend: " + name + ", events: " + std::to_string(events) + ", overflows: " + std::to_string(overflows) +
+         ", watches: " + std::to_string(backend == Backend::INOTIFY ? watches.size() : 1);
+}
+
+}  // namespace nt